@@ -4,6 +4,7 @@
 #pragma once
 
 #include "../bitset_popcount.h"
+#include "../builtins.h"
 #include "../utils.h"
 #include "concepts.h"
 
@@ -120,6 +121,16 @@ struct Bitvector2L {
         return bit;
     }
 
+    // requests the memory accessed by symbol(idx) and rank(idx) without waiting for it
+    void prefetch(size_t idx) const noexcept {
+        auto bitId = idx % l1_bits_ct;
+        auto l1Id  = idx / l1_bits_ct;
+        auto l0Id  = idx / l0_bits_ct;
+        __builtin_prefetch(reinterpret_cast<void const*>(&l0[l0Id]), 0, 0);
+        __builtin_prefetch(reinterpret_cast<void const*>(&l1[l1Id]), 0, 0);
+        __builtin_prefetch(reinterpret_cast<char const*>(&bits[l1Id]) + bitId/8, 0, 0);
+    }
+
     uint64_t rank(size_t idx) const noexcept {
         assert(idx <= totalLength);
         auto bitId = idx % (l1_bits_ct);
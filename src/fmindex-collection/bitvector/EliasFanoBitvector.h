@@ -0,0 +1,220 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "concepts.h"
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+#include <ranges>
+#include <span>
+#include <tuple>
+#include <vector>
+
+namespace fmc::bitvector {
+
+/**
+ * Elias-Fano encoded bitvector
+ *
+ * Stores the positions of the ones, each split into `lowBits` lower bits (stored densely)
+ * and the remaining upper bits (stored unary in `high`). Requires about
+ * `m * (2 + log2(n/m))` bits for `m` ones out of `n` bits. For a suffix array sampled
+ * every 16th row this is ~0.4 bits per row, instead of ~1.1 bits per row (Bitvector2L).
+ *
+ * rank() looks up the number of ones before the closest sampled bucket (`bucketRanks`, one
+ * entry every `SampleRate` buckets), which gives the position of that bucket inside `high` and
+ * the index of its first lower bits. The upper bits are then scanned up to the requested
+ * bucket, which has on average less than two entries. The lower bits are requested
+ * together with the upper bits, but a lookup still depends on three memory accesses (sample,
+ * upper bits, lower bits) and remains several times slower than on a plain Bitvector2L,
+ * independent of `SampleRate`. It trades latency for space, e.g. BasicCSA<EliasFanoBitvector<>>.
+ */
+template <size_t SampleRate = 64>
+struct EliasFanoBitvector {
+    size_t                totalLength{};
+    size_t                ones{};
+    size_t                lowBits{};     // number of lower bits per position
+    std::vector<uint64_t> low;           // lower bits of each position, densely packed
+    std::vector<uint64_t> high;          // one bit per position, one zero per bucket of upper bits
+    std::vector<uint64_t> bucketRanks;   // number of ones in the buckets before bucket k * SampleRate
+
+    template <std::ranges::range range_t>
+        requires std::convertible_to<std::ranges::range_value_t<range_t>, uint8_t>
+    EliasFanoBitvector(range_t&& _range) {
+        for (auto v : _range) {
+            totalLength += 1;
+            ones        += (v != 0);
+        }
+        if (ones > 0 && totalLength / ones > 1) {
+            lowBits = std::bit_width(totalLength / ones) - 1;
+        }
+
+        auto buckets = (totalLength >> lowBits) + 1;
+        low.resize((ones * lowBits + 63) / 64 + 1, 0);
+        high.resize((ones + buckets + 63) / 64, 0);
+
+        size_t i{0};
+        size_t pos{0};
+        for (auto v : _range) {
+            if (v != 0) {
+                auto bucket = pos >> lowBits;
+                while (bucketRanks.size() * SampleRate <= bucket) {
+                    bucketRanks.push_back(i);
+                }
+                setLow(i, pos & lowMask());
+                auto bit = bucket + i;
+                high[bit / 64] |= uint64_t{1} << (bit % 64);
+                i += 1;
+            }
+            pos += 1;
+        }
+        while (bucketRanks.size() * SampleRate < buckets) {
+            bucketRanks.push_back(ones);
+        }
+    }
+
+    EliasFanoBitvector() = default;
+    EliasFanoBitvector(EliasFanoBitvector const&) = default;
+    EliasFanoBitvector(EliasFanoBitvector&&) noexcept = default;
+
+    auto operator=(EliasFanoBitvector const&) -> EliasFanoBitvector& = default;
+    auto operator=(EliasFanoBitvector&&) noexcept -> EliasFanoBitvector& = default;
+
+    size_t size() const noexcept {
+        return totalLength;
+    }
+
+    bool symbol(size_t idx) const noexcept {
+        assert(idx < size());
+        return std::get<1>(rankAndSymbol(idx));
+    }
+
+    uint64_t rank(size_t idx) const noexcept {
+        assert(idx <= size());
+        return std::get<0>(rankAndSymbol(idx));
+    }
+
+    /** Computes rank(idx) and symbol(idx) at once
+     *
+     * Both require locating the same bucket, e.g. SparseArray::value() uses this instead of two calls.
+     * symbol(size()) is reported as false.
+     */
+    auto rankAndSymbol(size_t idx) const noexcept -> std::tuple<uint64_t, bool> {
+        assert(idx <= size());
+        auto bucket = idx >> lowBits;
+        auto l      = idx & lowMask();
+
+        // first entry of the sampled bucket inside `high`
+        auto sample = bucket / SampleRate;
+        size_t r    = bucketRanks[sample];
+        size_t bit  = r + sample * SampleRate;
+
+        // the lower bits of `bucket` follow shortly after the ones of the sampled bucket
+        __builtin_prefetch(reinterpret_cast<void const*>(&low[r * lowBits / 64]), 0, 0);
+
+        // skip the remaining buckets
+        if (auto skip = bucket % SampleRate; skip > 0) {
+            bit = selectZeroFrom(bit, skip-1) + 1;
+            r   = bit - bucket;
+        }
+        while (highBit(bit)) {
+            auto v = getLow(r);
+            if (v >= l) {
+                return {r, v == l};
+            }
+            r   += 1;
+            bit += 1;
+        }
+        return {r, false};
+    }
+
+    // requests the bucket rank used by rank(idx)/symbol(idx)
+    void prefetch(size_t idx) const noexcept {
+        auto bucket = idx >> lowBits;
+        __builtin_prefetch(reinterpret_cast<void const*>(&bucketRanks[bucket / SampleRate]), 0, 0);
+    }
+
+    template <typename Archive>
+    void serialize(this auto&& self, Archive& ar) {
+        ar(self.totalLength, self.ones, self.lowBits, self.low, self.high, self.bucketRanks);
+    }
+
+    size_t space_usage() const {
+        return sizeof(totalLength) + sizeof(ones) + sizeof(lowBits)
+               + (low.size() + high.size() + bucketRanks.size()) * sizeof(uint64_t);
+    }
+
+private:
+    uint64_t lowMask() const noexcept {
+        return (uint64_t{1} << lowBits) - 1;
+    }
+
+    void setLow(size_t i, uint64_t value) {
+        if (lowBits == 0) return;
+        auto bit = i * lowBits;
+        low[bit / 64] |= value << (bit % 64);
+        if (bit % 64 + lowBits > 64) {
+            low[bit / 64 + 1] |= value >> (64 - bit % 64);
+        }
+    }
+
+    uint64_t getLow(size_t i) const noexcept {
+        if (lowBits == 0) return 0;
+        auto bit = i * lowBits;
+        auto w   = bit / 64;
+        auto o   = bit % 64;
+        // `low` has one word of padding, the second word only contributes if the value
+        // crosses the word boundary ((x << 1) << (63 - o) avoids a shift by 64)
+        auto v = (low[w] >> o) | ((low[w + 1] << 1) << (63 - o));
+        return v & lowMask();
+    }
+
+    bool highBit(size_t bit) const noexcept {
+        return (high[bit / 64] >> (bit % 64)) & 1;
+    }
+
+    //!\brief position of the `_k`-th (0-based) set bit of `_word`
+    static size_t selectInWord(uint64_t _word, size_t _k) noexcept {
+#if defined(__BMI2__)
+        return std::countr_zero(_pdep_u64(uint64_t{1} << _k, _word));
+#else
+        // skip whole bytes, then single bits
+        size_t offset{0};
+        while (true) {
+            auto c = size_t(std::popcount(_word & 0xff));
+            if (_k < c) break;
+            _k     -= c;
+            _word >>= 8;
+            offset += 8;
+        }
+        for (; _k > 0; --_k) {
+            _word &= _word - 1;
+        }
+        return offset + std::countr_zero(_word);
+#endif
+    }
+
+    //!\brief position of the `_k`-th (0-based) zero inside `high` at or after position `_pos`
+    size_t selectZeroFrom(size_t _pos, size_t _k) const noexcept {
+        auto r    = _k;
+        auto w    = _pos / 64;
+        auto word = ~high[w] & (~uint64_t{0} << (_pos % 64));
+        while (true) {
+            auto c = size_t(std::popcount(word));
+            if (r < c) {
+                return w * 64 + selectInWord(word, r);
+            }
+            r   -= c;
+            w   += 1;
+            word = ~high[w];
+        }
+    }
+};
+static_assert(Bitvector_c<EliasFanoBitvector<>>);
+
+}
@@ -9,6 +9,7 @@
 #include "InvertedBitvector.h"
 #include "PrunedBitvector.h"
 #include "CompactBitvector.h"
+#include "EliasFanoBitvector.h"
 #include "CompactBitvector4Blocks.h"
 #include "CompactPairedL1L2_NBitvector.h"
 #include "InterleavedPairedL0L1_NBitvector.h"
@@ -3,6 +3,8 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include "KMerLookupTable.h"
+#include "SampledISA.h"
 #include "../string/FlattenedBitvectors2L.h"
 #include "../string/concepts.h"
 #include "../suffixarray/SparseArray.h"
@@ -11,6 +13,7 @@
 
 #include <algorithm>
 #include <cassert>
+#include <future>
 
 namespace fmc {
 
@@ -34,13 +37,21 @@ struct BiFMIndex {
     std::array<size_t, Sigma+1> C{};
     SparseArray annotatedArray;
 
+    // optional, searches start at depth k if set, e.g.: `index.kmerLookup = KMerLookupTable{index, 12};`
+    // not part of the serialization, store it via saveIndexTables, rebuilt by fmindex::merge
+    KMerLookupTable kmerLookup;
+
+    // optional, required by extract, e.g.: `index.isa = SampledISA{index, 32};`
+    // not part of the serialization, store it via saveIndexTables, rebuilt by fmindex::merge
+    SampledISA isa;
+
     BiFMIndex() = default;
     BiFMIndex(BiFMIndex&&) noexcept = default;
 
-    BiFMIndex(std::span<uint8_t const> _bwt, std::span<uint8_t const> _bwtRev, SparseArray _annotatedArray)
+    BiFMIndex(std::span<uint8_t const> _bwt, std::span<uint8_t const> _bwtRev, SparseArray _annotatedArray, size_t _threadNbr = 1)
         requires(!TReuseRev)
-        : bwt{_bwt}
-        , bwtRev{_bwtRev}
+        : bwt{createString<String<Sigma>>(_bwt, _threadNbr)}
+        , bwtRev{createString<String<Sigma>>(_bwtRev, _threadNbr)}
         , C{computeC(bwt)}
         , annotatedArray{std::move(_annotatedArray)}
     {
@@ -50,9 +61,9 @@ struct BiFMIndex {
         }
     }
 
-    BiFMIndex(std::span<uint8_t const> _bwt, SparseArray _annotatedArray)
+    BiFMIndex(std::span<uint8_t const> _bwt, SparseArray _annotatedArray, size_t _threadNbr = 1)
         requires(TReuseRev)
-        : bwt{_bwt}
+        : bwt{createString<String<Sigma>>(_bwt, _threadNbr)}
         , C{computeC(bwt)}
         , annotatedArray{std::move(_annotatedArray)}
     {}
@@ -60,8 +71,10 @@ struct BiFMIndex {
 
     /*
      * \param includeReversedInput assumes that the input data also has the reversed input data
+     * \param concurrentBuild builds the forward and reverse index at the same time (if _threadNbr > 1),
+     *                        this copies the input text and holds both suffix arrays in memory at once
      */
-    BiFMIndex(Sequence auto const& _sequence, SparseArray const& _annotatedSequence, size_t _threadNbr, bool includeReversedInput = false) {
+    BiFMIndex(Sequence auto const& _sequence, SparseArray const& _annotatedSequence, size_t _threadNbr, bool includeReversedInput = false, bool concurrentBuild = false) {
         if (_sequence.size() >= std::numeric_limits<size_t>::max()/2) {
             throw std::runtime_error{"sequence is longer than what this system is capable of handling"};
         }
@@ -71,28 +84,41 @@ struct BiFMIndex {
         // copy text into custom buffer
         auto inputText = createInputText(_sequence, omegaSorting, includeReversedInput);
 
+        if constexpr (!TReuseRev) {
+            if (concurrentBuild && _threadNbr > 1) {
+                // build forward and reverse index concurrently, this requires memory for both suffix arrays at the same time
+                auto revThreadNbr = _threadNbr / 2;
+                auto inputTextRev = inputText;
+                reverseText(inputTextRev);
+                auto revBuild = std::async(std::launch::async, [&]() {
+                    auto _bwtRev = createBWT(inputTextRev, revThreadNbr, omegaSorting);
+                    decltype(inputTextRev){}.swap(inputTextRev); // inputTextRev memory can be deleted
+                    return createString<String<Sigma>>(_bwtRev, revThreadNbr);
+                });
+                auto [_bwt, _annotatedArray] = createBWTAndAnnotatedArray(inputText, _annotatedSequence, _threadNbr - revThreadNbr, omegaSorting);
+                decltype(inputText){}.swap(inputText); // inputText memory can be deleted
+
+                // initialize this BiFMIndex properly
+                bwt = createString<String<Sigma>>(_bwt, _threadNbr - revThreadNbr);
+                bwtRev = revBuild.get();
+                C = computeC(bwt);
+                annotatedArray = std::move(_annotatedArray);
+                return;
+            }
+        }
+
         // create bwt, bwtRev and annotatedArray
         auto [_bwt, _annotatedArray] = createBWTAndAnnotatedArray(inputText, _annotatedSequence, _threadNbr, omegaSorting);
 
-
         if constexpr (!TReuseRev) {
-            #if defined(__GNUC__) && !defined(__clang__)
-            #pragma GCC diagnostic push
-            #pragma GCC diagnostic ignored "-Wstringop-overflow"
-            std::ranges::reverse(inputText);
-            #pragma GCC diagnostic pop
-
-            #else
-            std::ranges::reverse(inputText);
-
-            #endif
+            reverseText(inputText);
             auto _bwtRev = createBWT(inputText, _threadNbr, omegaSorting);
             decltype(inputText){}.swap(inputText); // inputText memory can be deleted
-            bwtRev = {_bwtRev};
+            bwtRev = createString<String<Sigma>>(_bwtRev, _threadNbr);
         }
 
         // initialize this BiFMIndex properly
-        bwt = {_bwt};
+        bwt = createString<String<Sigma>>(_bwt, _threadNbr);
         C = computeC(bwt);
         annotatedArray = std::move(_annotatedArray);
     }
@@ -103,8 +129,9 @@ struct BiFMIndex {
      * \param _input a list of sequences
      * \param samplingRate rate of the sampling
      * \param includeReversedInput also adds all input and their reversed text
+     * \param concurrentBuild builds the forward and reverse index at the same time, trading peak memory for speed
      */
-    BiFMIndex(Sequences auto const& _input, size_t samplingRate, size_t threadNbr, size_t seqOffset = 0, bool includeReversedInput = false) {
+    BiFMIndex(Sequences auto const& _input, size_t samplingRate, size_t threadNbr, size_t seqOffset = 0, bool includeReversedInput = false, bool concurrentBuild = false) {
         auto [totalSize, inputText, inputSizes] = createSequences(_input, /*._addReversed=*/includeReversedInput, /*._useDelimiters=*/Delim_v);
 
         size_t refId{0};
@@ -163,12 +190,27 @@ struct BiFMIndex {
             })
         };
 
-        *this = BiFMIndex{inputText, annotatedSequence, threadNbr, /*includeReversedInput=*/false};
+        *this = BiFMIndex{inputText, annotatedSequence, threadNbr, /*includeReversedInput=*/false, concurrentBuild};
     }
 
     auto operator=(BiFMIndex const&) -> BiFMIndex& = delete;
     auto operator=(BiFMIndex&& _other) noexcept -> BiFMIndex& = default;
 
+private:
+    static void reverseText(std::vector<uint8_t>& _text) {
+        #if defined(__GNUC__) && !defined(__clang__)
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wstringop-overflow"
+        std::ranges::reverse(_text);
+        #pragma GCC diagnostic pop
+
+        #else
+        std::ranges::reverse(_text);
+
+        #endif
+    }
+public:
+
     size_t size() const {
         return bwt.size();
     }
@@ -201,10 +243,29 @@ struct BiFMIndex {
         }
     }
 
+    /**!\brief Like locate, but reports the number of LF steps to `stats`
+     *
+     * \param stats instrumentation policy, see instrumentation::Counters
+     */
+    template <typename Stats>
+    auto locate(size_t idx, Stats& stats) const -> LEntry {
+        auto res = locate(idx);
+        stats.locateSteps(std::get<std::tuple_size_v<LEntry>-1>(res));
+        return res;
+    }
+
     auto single_locate_step(size_t idx) const -> std::optional<ADEntry> {
         return annotatedArray.value(idx);
     }
 
+    /**!\brief Extracts `text[seqId][begin, end)`, requires `isa` to be initialized
+     *
+     * Costs O(isa.samplingRate + end - begin) rank operations.
+     */
+    auto extract(size_t seqId, size_t begin, size_t end) const -> std::vector<uint8_t> {
+        return isa.extract(*this, seqId, begin, end);
+    }
+
 
     template <typename Archive>
     void serialize(this auto&& self, Archive& ar) {
@@ -0,0 +1,171 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "merge.h"
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <stdexcept>
+
+namespace fmc {
+
+/**
+ * An index that supports appending sequences without rebuilding it (LSM style)
+ *
+ * Appended sequences are indexed in small delta indices, which are searched
+ * alongside the main index. Deltas of similar size are merged with each other
+ * (size tiered), so the number of deltas stays logarithmic in the number of
+ * appends. A compaction merges all deltas into the main index, optionally in
+ * the background.
+ *
+ * All sequences have globally unique seqIds: the sequences of the main index
+ * have the ids [0, seqCount) of construction time, appended sequences are
+ * numbered consecutively after them. Results of `locate` are therefore valid
+ * no matter in which index they were found.
+ *
+ * Deltas are built without a k-mer lookup table or inverse suffix array. A
+ * compaction rebuilds those of `main` on the compacted index (see fmindex::merge).
+ *
+ * Member functions must not be called concurrently with each other. While a
+ * background compaction is running, `main` and `deltas` may be searched.
+ *
+ * \tparam Index an FMIndex or BiFMIndex
+ */
+template <typename Index>
+struct DeltaIndex {
+    Index main;
+    std::deque<Index> deltas; // deque keeps the addresses of the deltas stable
+    size_t seqCount{};
+    size_t samplingRate{};
+    size_t threadNbr{};
+
+private:
+    std::vector<size_t> deltaLevels;   // merge level of each delta
+    size_t frozenDeltas{};             // number of leading deltas that are being compacted
+    std::future<Index> compaction;
+
+public:
+    /**
+     * \param _main         existing index
+     * \param _seqCount     number of sequences in `_main`
+     * \param _samplingRate sampling rate of appended sequences
+     * \param _threadNbr    number of threads used for indexing and merging
+     */
+    DeltaIndex(Index _main, size_t _seqCount, size_t _samplingRate, size_t _threadNbr = 1)
+        : main{std::move(_main)}
+        , seqCount{_seqCount}
+        , samplingRate{_samplingRate}
+        , threadNbr{_threadNbr}
+    {}
+
+    DeltaIndex(DeltaIndex const&) = delete;
+    DeltaIndex(DeltaIndex&&) = delete; // a running compaction refers to this object
+    auto operator=(DeltaIndex const&) -> DeltaIndex& = delete;
+    auto operator=(DeltaIndex&&) -> DeltaIndex& = delete;
+
+    ~DeltaIndex() {
+        if (compaction.valid()) {
+            compaction.wait();
+        }
+    }
+
+    /**
+     * Adds sequences to the index
+     *
+     * \param _input a list of sequences
+     * \return seqId of the first appended sequence
+     */
+    auto append(Sequences auto const& _input) -> size_t {
+        auto firstSeqId = seqCount;
+        if (_input.size() == 0) return firstSeqId;
+
+        deltas.push_back(fmindex::detail::createIndex<Index>(_input, samplingRate, threadNbr, firstSeqId));
+        deltaLevels.push_back(0);
+        seqCount += _input.size();
+
+        // merge deltas of the same level, deltas that are being compacted are not touched
+        while (deltas.size() > frozenDeltas + 1 && deltaLevels.back() == deltaLevels[deltaLevels.size()-2]) {
+            auto rhs = std::move(deltas.back());
+            deltas.pop_back();
+            deltaLevels.pop_back();
+            deltas.back() = fmindex::merge(deltas.back(), rhs, threadNbr);
+            deltaLevels.back() += 1;
+        }
+        return firstSeqId;
+    }
+
+    /**
+     * Starts merging all current deltas into the main index on a background thread
+     *
+     * Does nothing if a compaction is already running or no deltas exist.
+     * Sequences appended while the compaction is running go into new deltas.
+     * The result is applied by `finishCompaction()`.
+     */
+    void startCompaction() {
+        if (compaction.valid() || deltas.empty()) return;
+
+        frozenDeltas = deltas.size();
+        auto indices = std::vector<Index const*>{&main};
+        for (size_t i{0}; i < frozenDeltas; ++i) {
+            indices.push_back(&deltas[i]);
+        }
+        compaction = std::async(std::launch::async, [indices = std::move(indices), threads = threadNbr]() {
+            return fmindex::merge(indices, threads);
+        });
+    }
+
+    /**
+     * Applies a finished background compaction
+     *
+     * \param _wait block until the compaction is finished
+     * \return true if a compaction was applied
+     */
+    bool finishCompaction(bool _wait = false) {
+        if (!compaction.valid()) return false;
+        if (!_wait && compaction.wait_for(std::chrono::seconds{0}) != std::future_status::ready) {
+            return false;
+        }
+        main = compaction.get();
+        deltas.erase(deltas.begin(), deltas.begin() + frozenDeltas);
+        deltaLevels.erase(deltaLevels.begin(), deltaLevels.begin() + frozenDeltas);
+        frozenDeltas = 0;
+        return true;
+    }
+
+    /**
+     * Merges all deltas into the main index, blocks until done
+     */
+    void compact() {
+        finishCompaction(/*._wait=*/true);
+        startCompaction();
+        finishCompaction(/*._wait=*/true);
+    }
+
+    /**
+     * Calls `_cb(index)` for the main index and every delta
+     *
+     * This is the way to search the DeltaIndex: run the search on every index,
+     * the reported seqIds are globally valid.
+     */
+    template <typename cb_t>
+    void forEachIndex(cb_t&& _cb) const {
+        _cb(main);
+        for (auto const& delta : deltas) {
+            _cb(delta);
+        }
+    }
+
+    /** number of rows over all indices
+     */
+    size_t size() const {
+        size_t total = main.size();
+        for (auto const& delta : deltas) {
+            total += delta.size();
+        }
+        return total;
+    }
+};
+
+}
@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include "SampledISA.h"
 #include "../string/concepts.h"
 #include "../string/utils.h"
 #include "../string/FlattenedBitvectors2L.h"
@@ -22,11 +23,15 @@ struct FMIndex {
     std::array<size_t, Sigma+1> C{0};
     SparseArray annotatedArray;
 
+    // optional, required by extract, e.g.: `index.isa = SampledISA{index, 32};`
+    // not part of the serialization, store it via saveIndexTables, rebuilt by fmindex::merge
+    SampledISA isa;
+
     FMIndex() = default;
     FMIndex(FMIndex const&) = delete;
     FMIndex(FMIndex&&) noexcept = default;
-    FMIndex(std::span<uint8_t const> _bwt, SparseArray _annotatedArray)
-        : bwt{_bwt}
+    FMIndex(std::span<uint8_t const> _bwt, SparseArray _annotatedArray, size_t _threadNbr = 1)
+        : bwt{createString<String<Sigma>>(_bwt, _threadNbr)}
         , C{computeC(bwt)}
         , annotatedArray{std::move(_annotatedArray)}
     {}
@@ -40,7 +45,7 @@ struct FMIndex {
         decltype(inputText){}.swap(inputText); // inputText memory can be deleted
 
         // initialize this FMIndex properly
-        bwt = {_bwt};
+        bwt = createString<String<Sigma>>(_bwt, _threadNbr);
         C = computeC(bwt);
         annotatedArray = std::move(_annotatedArray);
     }
@@ -127,6 +132,14 @@ struct FMIndex {
         return annotatedArray.value(idx);
     }
 
+    /**!\brief Extracts `text[seqId][begin, end)`, requires `isa` to be initialized
+     *
+     * Costs O(isa.samplingRate + end - begin) rank operations.
+     */
+    auto extract(size_t seqId, size_t begin, size_t end) const -> std::vector<uint8_t> {
+        return isa.extract(*this, seqId, begin, end);
+    }
+
     template <typename Archive>
     void serialize(this auto&& self, Archive& ar) {
         ar(self.bwt, self.C, self.annotatedArray);
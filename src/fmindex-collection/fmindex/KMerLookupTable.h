@@ -0,0 +1,131 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../parallel.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mmser/mmser.h>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#if __has_include(<cereal/types/vector.hpp>)
+#include <cereal/types/vector.hpp>
+#endif
+
+namespace fmc {
+
+/**
+ * Precomputed bidirectional intervals of all k-mers
+ *
+ * Looking up the interval of a k-mer replaces the first k backward search steps,
+ * which are dependent rank queries on the (still large) intervals near the root.
+ * A k-mer is encoded as a number in base `Sigma - FirstSymb`, the table has one
+ * entry per possible k-mer, so it requires `(Sigma-FirstSymb)^k * 24` bytes.
+ * For DNA (4 symbols) and k=12 this is about 400MB.
+ */
+struct KMerLookupTable {
+    struct Entry {
+        uint64_t lb{};
+        uint64_t lbRev{};
+        uint64_t len{};
+
+        template <typename Archive>
+        void serialize(this auto&& self, Archive& ar) {
+            ar(self.lb, self.lbRev, self.len);
+        }
+    };
+
+    size_t k{};         // length of the k-mers, 0 if the table is empty
+    size_t firstSymb{}; // smallest symbol that is part of the k-mer alphabet
+    size_t base{};      // number of symbols in the k-mer alphabet
+    mmser::vector<Entry> entries;
+    static_assert(mmser::is_trivially_copyable_t<Entry>::value, "entries are memory mapped by loadIndexTablesMMap");
+
+    KMerLookupTable() = default;
+
+    /**
+     * \param _index     a BiFMIndex
+     * \param _k         length of the k-mers
+     * \param _threadNbr number of threads
+     */
+    template <typename Index>
+    KMerLookupTable(Index const& _index, size_t _k, size_t _threadNbr = 1)
+        : k{_k}
+        , firstSymb{Index::FirstSymb}
+        , base{Index::Sigma - Index::FirstSymb}
+    {
+        size_t tableSize{1};
+        for (size_t i{0}; i < k; ++i) {
+            if (tableSize > std::numeric_limits<uint32_t>::max() / base) {
+                throw std::runtime_error{"k-mer lookup table would be too large"};
+            }
+            tableSize *= base;
+        }
+        entries.resize(tableSize);
+
+        // weight of the symbol that is added at depth d (extending to the left)
+        auto weights = std::vector<size_t>(k+1, 1);
+        for (size_t d{1}; d <= k; ++d) {
+            weights[d] = weights[d-1] * base;
+        }
+
+        auto const& bwt = _index.bwt;
+        auto extend = [&](auto const& rec, Entry const& cur, size_t depth, size_t value) -> void {
+            if (depth == k) {
+                entries[value] = cur;
+                return;
+            }
+            auto [rs1, prs1] = bwt.all_ranks_and_prefix_ranks(cur.lb);
+            auto [rs2, prs2] = bwt.all_ranks_and_prefix_ranks(cur.lb + cur.len);
+            for (size_t s{firstSymb}; s < Index::Sigma; ++s) {
+                auto next = Entry{rs1[s] + _index.C[s], cur.lbRev + prs2[s] - prs1[s], rs2[s] - rs1[s]};
+                if (next.len == 0) continue; // entries are already zero initialized
+                rec(rec, next, depth+1, value + (s - firstSymb) * weights[depth]);
+            }
+        };
+
+        if (k == 0) return;
+        // each subtree of the last symbol of a k-mer is filled by its own task
+        auto root = Entry{0, 0, _index.size()};
+        auto [rs1, prs1] = bwt.all_ranks_and_prefix_ranks(root.lb);
+        auto [rs2, prs2] = bwt.all_ranks_and_prefix_ranks(root.lb + root.len);
+        parallelFor(base, _threadNbr, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i) {
+                auto s    = i + firstSymb;
+                auto next = Entry{rs1[s] + _index.C[s], root.lbRev + prs2[s] - prs1[s], rs2[s] - rs1[s]};
+                if (next.len == 0) continue;
+                extend(extend, next, 1, i);
+            }
+        });
+    }
+
+    /**
+     * Looks up the interval of `_query[_begin, _begin+k)`
+     *
+     * \return (lb, lbRev, len) or std::nullopt if the table is empty, the query is too short or contains symbols outside of the k-mer alphabet
+     */
+    template <typename query_t>
+    auto find(query_t const& _query, size_t _begin) const -> std::optional<std::tuple<size_t, size_t, size_t>> {
+        if (k == 0 || _begin + k > _query.size()) return std::nullopt;
+        size_t value{0};
+        for (size_t i{0}; i < k; ++i) {
+            auto s = static_cast<size_t>(_query[_begin + i]);
+            if (s < firstSymb || s >= firstSymb + base) return std::nullopt;
+            value = value * base + (s - firstSymb);
+        }
+        auto const& e = entries[value];
+        return std::make_tuple(size_t{e.lb}, size_t{e.lbRev}, size_t{e.len});
+    }
+
+    template <typename Archive>
+    void serialize(this auto&& self, Archive& ar) {
+        ar(self.k, self.firstSymb, self.base, self.entries);
+    }
+};
+
+}
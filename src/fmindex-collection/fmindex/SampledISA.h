@@ -0,0 +1,177 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../DenseVector.h"
+#include "../parallel.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <mmser/mmser.h>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#if __has_include(<cereal/types/vector.hpp>)
+#include <cereal/types/vector.hpp>
+#endif
+
+namespace fmc {
+
+/**
+ * Sampled inverse suffix array
+ *
+ * Stores the bwt row of every `samplingRate`-th text position, counted from the end
+ * of each sequence (CSA samples in suffix array space, this samples in text space).
+ * Extracting `text[seqId][begin, end)` starts at the closest sample at or behind `end`
+ * and walks LF backwards, costing O(samplingRate + end - begin) rank operations.
+ *
+ * Requires an index that was build with delimiters, sequence ids are the ones reported by locate.
+ */
+struct SampledISA {
+    size_t                  samplingRate{}; // 0 if no samples exists
+    size_t                  firstSeqId{};   // smallest sequence id (e.g. the seqOffset of the index)
+    mmser::vector<uint64_t> lengths;        // length of each sequence, excluding the delimiter
+    mmser::vector<uint64_t> offsets;        // first entry of each sequence inside `rows`
+    DenseVector             rows;           // rows[offsets[s] + j] is the bwt row of text position `lengths[s] - j * samplingRate`
+
+    SampledISA() = default;
+
+    /**
+     * \param _index        a FMIndex or BiFMIndex
+     * \param _samplingRate distance between two sampled text positions
+     * \param _threadNbr    number of threads, each sequence is processed by a single thread
+     */
+    template <typename Index>
+    SampledISA(Index const& _index, size_t _samplingRate, size_t _threadNbr = 1)
+        : samplingRate{_samplingRate}
+        , rows(_index.size())
+    {
+        if (samplingRate == 0) {
+            throw std::runtime_error{"sampling rate of the inverse suffix array must be larger than 0"};
+        }
+
+        // the first `nbrOfSeq` rows of the bwt belong to the suffixes starting with a delimiter
+        auto nbrOfSeq = _index.bwt.rank(_index.size(), 0) + _index.C[0];
+        if (nbrOfSeq == 0) return;
+
+        auto seqIds = std::vector<size_t>(nbrOfSeq);
+        for (size_t i{0}; i < nbrOfSeq; ++i) {
+            seqIds[i] = std::get<0>(_index.locate(i));
+        }
+        firstSeqId = std::ranges::min(seqIds);
+
+        // sampled rows of each sequence, indexed by `seqId - firstSeqId`
+        auto samples = std::vector<std::vector<uint64_t>>(nbrOfSeq);
+        lengths.resize(nbrOfSeq);
+        for (auto seqId : seqIds) {
+            if (seqId - firstSeqId >= nbrOfSeq || !samples[seqId - firstSeqId].empty()) {
+                throw std::runtime_error{"sequence ids of the index are not consecutive"};
+            }
+            samples[seqId - firstSeqId].push_back(0); // marks as seen, replaced below
+        }
+
+        parallelFor(nbrOfSeq, _threadNbr, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+            for (size_t i{begin}; i < end; ++i) {
+                auto s = seqIds[i] - firstSeqId;
+                auto& sample = samples[s];
+                sample.clear();
+
+                size_t idx = i;
+                size_t steps{0};
+                while (true) {
+                    if (steps % samplingRate == 0) {
+                        sample.push_back(idx);
+                    }
+                    auto symb = _index.bwt.symbol(idx);
+                    if (symb == 0) break;
+                    idx = _index.bwt.rank(idx, symb) + _index.C[symb];
+                    steps += 1;
+                }
+                lengths[s] = steps;
+            }
+        });
+
+        offsets.reserve(nbrOfSeq);
+        for (auto const& sample : samples) {
+            offsets.push_back(rows.size());
+            for (auto v : sample) {
+                rows.push_back(v);
+            }
+        }
+    }
+
+    //!\brief number of sequences
+    size_t size() const {
+        return lengths.size();
+    }
+
+    //!\brief length of sequence `_seqId`, excluding the delimiter
+    size_t length(size_t _seqId) const {
+        checkSeqId(_seqId);
+        return lengths[_seqId - firstSeqId];
+    }
+
+    /**
+     * Bwt row of the suffix starting at `text[_seqId][_pos]`
+     *
+     * \param _pos must be in [0, length(_seqId)], the length itself refers to the delimiter
+     */
+    template <typename Index>
+    size_t inverse(Index const& _index, size_t _seqId, size_t _pos) const {
+        auto [idx, pos] = closestSample(_seqId, _pos);
+        for (; pos > _pos; --pos) {
+            auto symb = _index.bwt.symbol(idx);
+            idx = _index.bwt.rank(idx, symb) + _index.C[symb];
+        }
+        return idx;
+    }
+
+    /**
+     * Extracts `text[_seqId][_begin, _end)`
+     */
+    template <typename Index>
+    auto extract(Index const& _index, size_t _seqId, size_t _begin, size_t _end) const -> std::vector<uint8_t> {
+        if (_begin > _end) {
+            throw std::runtime_error{"invalid range [" + std::to_string(_begin) + ", " + std::to_string(_end) + ")"};
+        }
+        auto [idx, pos] = closestSample(_seqId, _end);
+        auto r = std::vector<uint8_t>(_end - _begin);
+        for (; pos > _begin; --pos) {
+            auto symb = _index.bwt.symbol(idx);
+            idx = _index.bwt.rank(idx, symb) + _index.C[symb];
+            if (pos <= _end) {
+                r[pos - 1 - _begin] = symb;
+            }
+        }
+        return r;
+    }
+
+    template <typename Archive>
+    void serialize(this auto&& self, Archive& ar) {
+        ar(self.samplingRate, self.firstSeqId, self.lengths, self.offsets, self.rows);
+    }
+
+private:
+    void checkSeqId(size_t _seqId) const {
+        if (_seqId < firstSeqId || _seqId - firstSeqId >= lengths.size()) {
+            throw std::runtime_error{"unknown sequence id " + std::to_string(_seqId) + ", is the inverse suffix array initialized?"};
+        }
+    }
+
+    //!\brief returns (row, text position) of the closest sample at or behind `_pos`
+    auto closestSample(size_t _seqId, size_t _pos) const -> std::tuple<size_t, size_t> {
+        checkSeqId(_seqId);
+        auto s   = _seqId - firstSeqId;
+        auto len = lengths[s];
+        if (_pos > len) {
+            throw std::runtime_error{"position " + std::to_string(_pos) + " is outside of sequence " + std::to_string(_seqId) + " with length " + std::to_string(len)};
+        }
+        auto j = (len - _pos) / samplingRate;
+        return {rows[offsets[s] + j], len - j * samplingRate};
+    }
+};
+
+}
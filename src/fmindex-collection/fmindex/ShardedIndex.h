@@ -0,0 +1,207 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../locate.h"
+#include "../parallel.h"
+#include "../search/Backtracking.h"
+#include "../search/search.h"
+#include "merge.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+namespace fmc {
+
+/**
+ * A collection of independently built indices (shards) that is searched as one index
+ *
+ * Each shard covers a consecutive range of sequences and is built with a sequence offset,
+ * such that all reported seqIds are globally valid. Shards can be built separately (e.g. on
+ * different machines) and added via `appendShard`, or rebuilt one at a time via `rebuildShard`.
+ *
+ * `search` runs each chunk of queries against all shards in parallel and merges the hits of
+ * all shards into one stream. Per query, hits are ordered by (seqId, pos, errors), so the
+ * stream does not depend on the number of shards, the number of threads or the scheduling.
+ *
+ * Shards are built without a k-mer lookup table or inverse suffix array, set them on each
+ * shard if needed (e.g. `shards[i].kmerLookup = KMerLookupTable{shards[i], 12};`).
+ * `appendShard` keeps the tables of the given shard, `rebuildShard` creates a shard without them.
+ *
+ * \tparam Index an FMIndex or BiFMIndex, unidirectional indices are searched by backtracking (edit distance only)
+ */
+template <typename Index>
+struct ShardedIndex {
+    std::vector<Index>  shards;
+    std::vector<size_t> seqOffsets{0}; // seqId of the first sequence of each shard, followed by the total number of sequences
+
+    ShardedIndex() = default;
+
+    /**
+     * Splits `_input` into `_shardCount` groups of consecutive sequences of similar total length
+     * and builds one shard per group
+     *
+     * \param _input        a list of sequences
+     * \param _shardCount   number of shards, at most one shard per sequence is created
+     * \param _samplingRate sampling rate of the suffix arrays
+     * \param _threadNbr    number of threads, split across the shards that are built concurrently
+     */
+    ShardedIndex(Sequences auto const& _input, size_t _shardCount, size_t _samplingRate, size_t _threadNbr = 1) {
+        if (_input.size() == 0) return;
+        _shardCount = std::clamp<size_t>(_shardCount, 1, _input.size());
+
+        size_t totalLength{0};
+        for (auto const& seq : _input) {
+            totalLength += seq.size();
+        }
+
+        // close a group as soon as it reaches its share of the total length
+        size_t length{0};
+        for (size_t i{0}; i < _input.size(); ++i) {
+            length += _input[i].size();
+            auto shardsLeft = _shardCount - (seqOffsets.size() - 1);
+            auto seqsLeft   = _input.size() - i - 1;
+            bool full = length * _shardCount >= totalLength * seqOffsets.size();
+            if (shardsLeft > 1 && (full || seqsLeft < shardsLeft)) {
+                seqOffsets.push_back(i+1);
+            }
+        }
+        if (seqOffsets.back() != _input.size()) {
+            seqOffsets.push_back(_input.size());
+        }
+
+        shards.resize(seqOffsets.size() - 1);
+
+        // with fewer shards than threads, the remaining threads are used to build each shard
+        auto const concurrent = std::clamp<size_t>(_threadNbr, 1, shards.size());
+        auto threadsOf = [&](size_t shard) {
+            return std::max<size_t>(1, _threadNbr / concurrent + (shard % concurrent < _threadNbr % concurrent));
+        };
+        parallelFor(shards.size(), concurrent, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+            for (size_t shard{begin}; shard < end; ++shard) {
+                shards[shard] = createShard(_input, seqOffsets[shard], seqOffsets[shard+1], _samplingRate, threadsOf(shard));
+            }
+        });
+    }
+
+    //!\brief number of shards
+    size_t size() const {
+        return shards.size();
+    }
+
+    //!\brief number of sequences over all shards
+    size_t seqCount() const {
+        return seqOffsets.back();
+    }
+
+    //!\brief shard that contains sequence `_seqId`
+    size_t shardOf(size_t _seqId) const {
+        return static_cast<size_t>(std::ranges::upper_bound(seqOffsets, _seqId) - seqOffsets.begin()) - 1;
+    }
+
+    /**
+     * Adds an independently built shard
+     *
+     * \param _shard    the index, it must have been built with a seqOffset of `seqCount()`
+     * \param _seqCount number of sequences in `_shard`
+     * \return id of the new shard
+     */
+    auto appendShard(Index _shard, size_t _seqCount) -> size_t {
+        shards.push_back(std::move(_shard));
+        seqOffsets.push_back(seqOffsets.back() + _seqCount);
+        return shards.size() - 1;
+    }
+
+    /**
+     * Replaces a shard by a new index over `_input`
+     *
+     * \param _shard        id of the shard
+     * \param _input        new sequences, must have as many sequences as the shard had before
+     * \param _samplingRate sampling rate of the suffix array
+     * \param _threadNbr    number of threads used to build the shard
+     */
+    void rebuildShard(size_t _shard, Sequences auto const& _input, size_t _samplingRate, size_t _threadNbr = 1) {
+        if (_input.size() != seqOffsets[_shard+1] - seqOffsets[_shard]) {
+            throw std::runtime_error{"rebuilding a shard requires the same number of sequences"};
+        }
+        shards[_shard] = createShard(_input, 0, _input.size(), _samplingRate, _threadNbr, seqOffsets[_shard]);
+    }
+
+    /**
+     * Searches all queries in all shards and reports located hits
+     *
+     * The queries are split into chunks, each pair of chunk and shard is processed as one unit
+     * of work on `_threadNbr` threads. Results are reported chunk by chunk as
+     * `_delegate(qidx, seqId, pos, errors)`, ordered by (qidx, seqId, pos, errors).
+     * `_delegate` is never called concurrently.
+     *
+     * \param _queries   queries to search for
+     * \param _errors    maximal number of errors
+     * \param _delegate  callback `(size_t qidx, size_t seqId, size_t pos, size_t errors)`
+     * \param _threadNbr number of threads
+     * \param _chunkSize number of queries that are searched as one unit of work
+     */
+    template <bool EditDistance, Sequences queries_t, typename delegate_t>
+    void search(queries_t const& _queries, size_t _errors, delegate_t&& _delegate, size_t _threadNbr = 1, size_t _chunkSize = 256) const {
+        using Result = std::tuple<size_t, size_t, size_t, size_t>;
+
+        constexpr bool IsBidirectional = requires(Index const& index) {
+            { index.bwtRev };
+        };
+        if (!IsBidirectional && !EditDistance && _errors > 0) {
+            throw std::runtime_error{"sharded search with hamming distance requires bidirectional indices"};
+        }
+        if (shards.empty() || _queries.size() == 0) return;
+        _chunkSize = std::max<size_t>(1, _chunkSize);
+
+        auto const shardCt = shards.size();
+        auto const chunkCt = (_queries.size() + _chunkSize - 1) / _chunkSize;
+        auto queryBegin = std::ranges::begin(_queries);
+
+        // results of the shards of the current chunk
+        auto merged = std::vector<Result>{};
+        size_t reportedUnits{0};
+
+        parallelBatch<Result>(chunkCt * shardCt, _threadNbr, /*.chunkSize=*/1, [&](size_t unit, size_t, std::vector<Result>& buffer) {
+            auto const& index = shards[unit % shardCt];
+            auto begin = (unit / shardCt) * _chunkSize;
+            auto end   = std::min(begin + _chunkSize, _queries.size());
+            auto chunk = std::ranges::subrange(queryBegin + begin, queryBegin + end);
+            auto locate = [&](size_t qidx, auto const& cursor, size_t errors) {
+                for (auto [sid, spos, offset] : LocateLinear{index, cursor}) {
+                    buffer.emplace_back(begin + qidx, sid, spos+offset, errors);
+                }
+            };
+            if constexpr (IsBidirectional) {
+                fmc::search<EditDistance>(index, chunk, _errors, locate);
+            } else {
+                search_backtracking::search(index, chunk, _errors, locate);
+            }
+        }, [&](std::vector<Result> const& buffer) {
+            merged.insert(merged.end(), buffer.begin(), buffer.end());
+            reportedUnits += 1;
+            if (reportedUnits % shardCt != 0) return;
+
+            // all shards of this chunk are done
+            std::ranges::sort(merged);
+            for (auto const& [qidx, sid, pos, errors] : merged) {
+                _delegate(qidx, sid, pos, errors);
+            }
+            merged.clear();
+        });
+    }
+
+private:
+    static auto createShard(Sequences auto const& _input, size_t _begin, size_t _end, size_t _samplingRate, size_t _threadNbr) -> Index {
+        return createShard(_input, _begin, _end, _samplingRate, _threadNbr, _begin);
+    }
+
+    static auto createShard(Sequences auto const& _input, size_t _begin, size_t _end, size_t _samplingRate, size_t _threadNbr, size_t _seqOffset) -> Index {
+        auto group = std::ranges::subrange(std::ranges::begin(_input) + _begin, std::ranges::begin(_input) + _end);
+        return fmindex::detail::createIndex<Index>(group, _samplingRate, _threadNbr, _seqOffset);
+    }
+};
+
+}
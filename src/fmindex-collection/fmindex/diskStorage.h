@@ -5,10 +5,11 @@
 #include <cereal/archives/binary.hpp>
 #include <filesystem>
 #include <fstream>
+#include <mmser/mmser.h>
 
 namespace fmc {
 
-// loads an fm index from disk
+// saves an fm index to disk
 template <typename Index>
 void saveIndex(Index const& _index, std::filesystem::path _fileName) {
     auto ofs     = std::ofstream(_fileName, std::ios::binary);
@@ -26,4 +27,79 @@ auto loadIndex(std::filesystem::path _fileName) {
     return index;
 }
 
+// saves an fm index to disk, in a format that can be loaded via loadIndexMMap
+template <typename Index>
+void saveIndexMMap(Index const& _index, std::filesystem::path _fileName) {
+    mmser::saveFile(_fileName, _index);
+}
+
+/* loads an fm index from disk by memory mapping the file
+ *
+ * All `mmser::vector` members (bwt strings, sparse arrays, dense vectors, sampled suffix arrays)
+ * use the mapped file as backing storage instead of copying it. Pages are read lazily and are
+ * shared via the page cache between all processes mapping the same file.
+ * The file must have been written by saveIndexMMap.
+ *
+ * The mapping is owned by the loaded `mmser::vector` members. Returning the index by value
+ * or moving it elsewhere moves these members and keeps the mapping alive; it is released when
+ * the last index holding it is destroyed. The file must not be modified or truncated meanwhile.
+ */
+template <typename Index>
+auto loadIndexMMap(std::filesystem::path _fileName) -> Index {
+    auto index = Index{};
+    mmser::loadFile(_fileName, index);
+    return index;
+}
+
+namespace detail {
+
+// the optional tables of an index, `kmerLookup` only exists for bidirectional indices
+template <typename Index>
+struct IndexTables {
+    Index& index;
+
+    template <typename Archive>
+    void serialize(this auto&& self, Archive& ar) {
+        if constexpr (requires { self.index.kmerLookup; }) {
+            ar(self.index.kmerLookup);
+        }
+        ar(self.index.isa);
+    }
+};
+
+}
+
+/* saves the optional tables of an fm index (kmerLookup and isa) to disk
+ *
+ * They are not part of the index file written by saveIndex/saveIndexMMap, which
+ * keeps that format unchanged. Store them next to it, e.g. in "<index>.tables".
+ */
+template <typename Index>
+void saveIndexTables(Index const& _index, std::filesystem::path _fileName) {
+    auto ofs     = std::ofstream(_fileName, std::ios::binary);
+    auto archive = cereal::BinaryOutputArchive{ofs};
+    archive(detail::IndexTables<Index const>{_index});
+}
+
+// loads the tables written by saveIndexTables into `_index`, which must be the same index
+template <typename Index>
+void loadIndexTables(Index& _index, std::filesystem::path _fileName) {
+    auto ifs     = std::ifstream(_fileName, std::ios::binary);
+    auto archive = cereal::BinaryInputArchive{ifs};
+    archive(detail::IndexTables<Index>{_index});
+}
+
+// saves the optional tables of an fm index, in a format that can be loaded via loadIndexTablesMMap
+template <typename Index>
+void saveIndexTablesMMap(Index const& _index, std::filesystem::path _fileName) {
+    mmser::saveFile(_fileName, detail::IndexTables<Index const>{_index});
+}
+
+// loads the tables written by saveIndexTablesMMap into `_index` by memory mapping the file, see loadIndexMMap
+template <typename Index>
+void loadIndexTablesMMap(Index& _index, std::filesystem::path _fileName) {
+    auto tables = detail::IndexTables<Index>{_index};
+    mmser::loadFile(_fileName, tables);
+}
+
 }
@@ -5,9 +5,17 @@
 
 #include "FMIndex.h"
 #include "BiFMIndex.h"
+#include "../parallel.h"
 #include "../string/utils.h"
+#include "../utils.h"
 
+#include <atomic>
+#include <bit>
 #include <cassert>
+#include <limits>
+#include <memory>
+#include <ranges>
+#include <tuple>
 #include <type_traits>
 #include <vector>
 
@@ -15,18 +23,68 @@ namespace fmc::fmindex {
 
 namespace detail {
 
+/**
+ * Bit vector over the rows of a merged index, indicating with 'false' that a
+ * row originates from lhs and with 'true' that it originates from rhs.
+ *
+ * Bits are stored in 64bit words, so they can be set concurrently and ranks
+ * can be computed cheaply after computeRanks() was called.
+ */
+struct InterleavingR {
+    std::vector<uint64_t> words;
+    std::vector<uint64_t> wordRanks; // number of set bits before each word
+    size_t length{};
+
+    explicit InterleavingR(size_t _length)
+        : words(_length/64 + 1)
+        , length{_length}
+    {}
+
+    size_t size() const {
+        return length;
+    }
+
+    bool operator[](size_t idx) const {
+        assert(idx < length);
+        return (words[idx/64] >> (idx%64)) & 1;
+    }
+
+    //! sets the bit at idx, safe to be called concurrently, returns the previous value
+    bool set(size_t idx) {
+        assert(idx < length);
+        auto mask = uint64_t{1} << (idx%64);
+        auto prev = std::atomic_ref<uint64_t>{words[idx/64]}.fetch_or(mask, std::memory_order_relaxed);
+        return prev & mask;
+    }
+
+    void computeRanks() {
+        wordRanks.resize(words.size()+1);
+        for (size_t i{0}; i < words.size(); ++i) {
+            wordRanks[i+1] = wordRanks[i] + std::popcount(words[i]);
+        }
+    }
+
+    //! number of set bits in [0, idx), requires computeRanks()
+    size_t rank(size_t idx) const {
+        assert(idx <= length);
+        auto mask = (uint64_t{1} << (idx%64)) - 1;
+        return wordRanks[idx/64] + std::popcount(words[idx/64] & mask);
+    }
+};
+
 /**
  * Creates the R array for interleaving SA/BWT/FM-Indices.
  * \param lhsStr first bwt
  * \param rhsStr second bwt
- * \return an boolean array indicating in which slot which entry is expected
+ * \param threadNbr number of threads, the sequences of rhsStr are distributed over the threads
+ * \return an InterleavingR indicating in which slot which entry is expected
  *
  * The R array has the same size as lhsStr and rhsStr together. It indicates
  * with 'false' that an entry from lhsStr is expected and with 'true' an entry from rhsStr.
  *
  */
 template <typename StringLhs, typename StringRhs, typename value_t = size_t>
-auto computeInterleavingR(StringLhs const& lhsStr, StringRhs const& rhsStr) -> std::vector<bool> {
+auto computeInterleavingR(StringLhs const& lhsStr, StringRhs const& rhsStr, size_t threadNbr = 1) -> InterleavingR {
     if (rhsStr.size() > std::numeric_limits<value_t>::max()) {
         throw std::runtime_error{"Can not create interleaving R for this value type, index to large"};
     }
@@ -34,63 +92,65 @@ auto computeInterleavingR(StringLhs const& lhsStr, StringRhs const& rhsStr) -> s
     auto lhsC = string::computeAccumulatedC(lhsStr);
     auto rhsC = string::computeAccumulatedC(rhsStr);
 
-    auto R = std::vector<bool>{};
-    R.resize(lhsStr.size() + rhsStr.size(), false);
+    auto R = InterleavingR{lhsStr.size() + rhsStr.size()};
 
+    // each sequence of rhs visits a distinct set of slots, sequences can be walked independently
     auto nbrOfSeqRhs = rhsStr.rank(rhsStr.size(), 0);
-    for (size_t n{}; n < nbrOfSeqRhs; ++n) {
-        size_t idx1{};
-        size_t idx2{n};
-        uint8_t c{};
-        do {
-            assert(idx1 + idx2 < R.size());
-            assert(R[idx1 + idx2] == false);
-            R[idx1 + idx2] = true;
-            c = rhsStr.symbol(idx2);
-            idx1 = lhsStr.rank(idx1, c) + lhsC[c];
-            idx2 = rhsStr.rank(idx2, c) + rhsC[c];
-        } while(c != 0);
-    }
-    assert([&]() {
-        size_t a{};
-        for (auto b : R) {
-            a += b;
-        }
-        return a;
-    }() == rhsStr.size());
+    parallelFor(nbrOfSeqRhs, threadNbr, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+        for (size_t n{begin}; n < end; ++n) {
+            size_t idx1{};
+            size_t idx2{n};
+            uint8_t c{};
+            do {
+                assert(idx1 + idx2 < R.size());
+                [[maybe_unused]] bool wasSet = R.set(idx1 + idx2);
+                assert(!wasSet);
+                c = rhsStr.symbol(idx2);
+                idx1 = lhsStr.rank(idx1, c) + lhsC[c];
+                idx2 = rhsStr.rank(idx2, c) + rhsC[c];
+            } while(c != 0);
+        }
+    });
+    R.computeRanks();
+    assert(R.rank(R.size()) == rhsStr.size());
     return R;
 }
 
 /** Creates a new BWT from two bwt that are merged with the help of an R array
+ *
+ * Blocks of the merged bwt are filled in parallel, the start of each block in lhsBwt and rhsBwt is given by the rank of R.
  */
 template <String_c StringLhs, String_c StringRhs>
-auto mergeBwt(std::vector<bool> const& R, StringLhs const& lhsBwt, StringRhs const& rhsBwt) -> std::vector<uint8_t> {
+auto mergeBwt(InterleavingR const& R, StringLhs const& lhsBwt, StringRhs const& rhsBwt, size_t threadNbr = 1) -> std::vector<uint8_t> {
     auto mergedBwt = std::vector<uint8_t>{};
-    mergedBwt.reserve(lhsBwt.size() + rhsBwt.size());
+    mergedBwt.resize(lhsBwt.size() + rhsBwt.size());
 
-    size_t idx1{}, idx2{};
-    for (bool v : R) {
-        if (!v) {
-            assert(idx1 < lhsBwt.size());
-            mergedBwt.push_back(lhsBwt.symbol(idx1));
-            idx1 += 1;
-        } else {
-            assert(idx2 < rhsBwt.size());
-            mergedBwt.push_back(rhsBwt.symbol(idx2));
-            idx2 += 1;
+    parallelFor(R.size(), threadNbr, /*.chunkSize=*/1ull<<16, [&](size_t begin, size_t end) {
+        size_t idx2 = R.rank(begin);
+        size_t idx1 = begin - idx2;
+        for (size_t i{begin}; i < end; ++i) {
+            if (!R[i]) {
+                assert(idx1 < lhsBwt.size());
+                mergedBwt[i] = lhsBwt.symbol(idx1);
+                idx1 += 1;
+            } else {
+                assert(idx2 < rhsBwt.size());
+                mergedBwt[i] = rhsBwt.symbol(idx2);
+                idx2 += 1;
+            }
         }
-    }
+    });
     return mergedBwt;
 }
 
 /** Creates a new CSA from two csa that are merged with the help of an R array
  */
 template <typename TCSA>
-auto mergeCsa(std::vector<bool> const& R, TCSA const& lhsCsa, TCSA const& rhsCsa) -> TCSA {
+auto mergeCsa(InterleavingR const& R, TCSA const& lhsCsa, TCSA const& rhsCsa) -> TCSA {
     auto csa = TCSA::createJoinedCSA(lhsCsa, rhsCsa);
     size_t idx1{}, idx2{};
-    for (bool v : R) {
-        if (!v) {
+    for (size_t i{0}; i < R.size(); ++i) {
+        if (!R[i]) {
             csa.push_back(lhsCsa.value(idx1));
             idx1 += 1;
         } else {
@@ -102,55 +162,395 @@ auto mergeCsa(std::vector<bool> const& R, TCSA const& lhsCsa, TCSA const& rhsCsa
 }
 
 template <typename T>
-auto mergeSparseArrays(std::vector<bool> const& R, suffixarray::SparseArray<T> const& lhs, suffixarray::SparseArray<T> const& rhs) {
-    auto counter = std::array<size_t, 2>{0, 0};
-
-    return suffixarray::SparseArray<T>{
-        std::views::iota(size_t{}, R.size()) |  std::views::transform([&](size_t phase) {
-            if (phase == 0) { // reset counters
-                counter[0] = 0;
-                counter[1] = 0;
+auto mergeSparseArrays(InterleavingR const& R, suffixarray::SparseArray<T> const& lhs, suffixarray::SparseArray<T> const& rhs, size_t threadNbr = 1) {
+    return createSparseArray<suffixarray::SparseArray<T>>(R.size(), [&](size_t i) {
+        auto r = R.rank(i);
+        if (!R[i]) {
+            return lhs.value(i - r);
+        } else {
+            return rhs.value(r);
+        }
+    }, threadNbr);
+}
+
+/**
+ * Merges k strings by repeatedly merging neighbours, forming a balanced tree
+ *
+ * Each symbol takes part in O(log k) merges. After each merge `_onMerge(lhs, R)`
+ * is called, where `lhs` is the position of the left string in the current level
+ * (the right string is at `lhs+1`). Afterwards both are replaced by the merged string.
+ *
+ * \return the merged string
+ */
+template <typename String, typename cb_t>
+auto mergeStringsBalanced(std::vector<String const*> _strings, size_t _threadNbr, cb_t&& _onMerge) -> String {
+    struct Node {
+        String const* str;
+        std::unique_ptr<String> owned; // set if this string is a merged string
+    };
+    auto level = std::vector<Node>{};
+    for (auto str : _strings) {
+        level.emplace_back(str, nullptr);
+    }
+    if (level.size() == 1) {
+        auto symbols = std::vector<uint8_t>(level[0].str->size());
+        for (size_t i{0}; i < symbols.size(); ++i) {
+            symbols[i] = level[0].str->symbol(i);
+        }
+        return createString<String>(symbols, _threadNbr);
+    }
+
+    while (level.size() > 1) {
+        auto nextLevel = std::vector<Node>{};
+        for (size_t i{0}; i+1 < level.size(); i += 2) {
+            auto R    = computeInterleavingR(*level[i].str, *level[i+1].str, _threadNbr);
+            auto owned = std::make_unique<String>(createString<String>(mergeBwt(R, *level[i].str, *level[i+1].str, _threadNbr), _threadNbr));
+            _onMerge(i, R);
+            // free memory of merged strings that are not needed anymore
+            level[i].owned.reset();
+            level[i+1].owned.reset();
+            auto ptr = owned.get();
+            nextLevel.emplace_back(ptr, std::move(owned));
+        }
+        if (level.size() % 2 == 1) {
+            nextLevel.emplace_back(std::move(level.back()));
+        }
+        level = std::move(nextLevel);
+    }
+    return std::move(*level[0].owned);
+}
+
+/**
+ * Merges the sparse arrays of k indices into one
+ *
+ * \param _sourceIds for each row of the merged index, the index it originates from
+ */
+template <typename SparseArray, typename SourceId>
+auto mergeSparseArraysKWay(std::vector<SourceId> const& _sourceIds, std::vector<SparseArray const*> const& _arrays, size_t _threadNbr) -> SparseArray {
+    using Entry = typename decltype(_arrays[0]->value(0))::value_type;
+
+    constexpr size_t BlockWords = size_t{1}<<12;
+    constexpr size_t BlockSize  = BlockWords * 64;
+    auto const size    = _sourceIds.size();
+    auto const wordCt  = (size + 63) / 64;
+    auto const blockCt = (wordCt + BlockWords - 1) / BlockWords;
+
+    // number of rows of each source before each block
+    auto blockStarts = std::vector<std::vector<size_t>>(blockCt+1, std::vector<size_t>(_arrays.size()));
+    parallelFor(blockCt, _threadNbr, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+        for (size_t b{begin}; b < end; ++b) {
+            for (size_t i{b*BlockSize}; i < std::min(size, (b+1)*BlockSize); ++i) {
+                blockStarts[b+1][_sourceIds[i]] += 1;
             }
-            bool b = R[phase];
+        }
+    });
+    for (size_t b{1}; b <= blockCt; ++b) {
+        for (size_t j{0}; j < _arrays.size(); ++j) {
+            blockStarts[b][j] += blockStarts[b-1][j];
+        }
+    }
 
-            counter[b] += 1;
-            if (!b) {
-                return lhs.value(counter[0]-1);
-            } else {
-                return rhs.value(counter[1]-1);
+    auto words   = std::vector<uint64_t>(wordCt);
+    auto entries = std::vector<Entry>{};
+    parallelBatch<Entry>(wordCt, _threadNbr, BlockWords, [&](size_t begin, size_t end, std::vector<Entry>& buffer) {
+        auto counters = blockStarts[begin / BlockWords];
+        for (size_t w{begin}; w < end; ++w) {
+            auto word = uint64_t{};
+            for (size_t i{w*64}; i < std::min(w*64+64, size); ++i) {
+                auto source = _sourceIds[i];
+                if (auto v = _arrays[source]->value(counters[source]++); v) {
+                    word |= uint64_t{1} << (i % 64);
+                    buffer.push_back(*v);
+                }
             }
-        })
-    };
+            words[w] = word;
+        }
+    }, [&](std::vector<Entry> const& buffer) {
+        entries.insert(entries.end(), buffer.begin(), buffer.end());
+    });
+    return createSparseArray<SparseArray>(size, words, entries);
 }
+
+/**
+ * Parameters of the optional lookup tables (kmerLookup, isa) of the indices being merged
+ *
+ * The tables depend on the bwt and can not be merged, they are rebuilt on the
+ * merged index instead, if any of the source indices had one.
+ */
+struct Lookups {
+    size_t kmerLength{};      // largest k of all added indices, 0 if none has a k-mer lookup table
+    size_t isaSamplingRate{}; // smallest sampling rate of all added indices, 0 if none has an inverse suffix array
+
+    template <typename Index>
+    void add(Index const& _index) {
+        if constexpr (requires() { { _index.kmerLookup.k }; }) {
+            kmerLength = std::max(kmerLength, _index.kmerLookup.k);
+        }
+        if constexpr (requires() { { _index.isa.samplingRate }; }) {
+            auto rate = _index.isa.samplingRate;
+            if (rate > 0 && (isaSamplingRate == 0 || rate < isaSamplingRate)) {
+                isaSamplingRate = rate;
+            }
+        }
+    }
+
+    template <typename Index>
+    void rebuild(Index& _index, size_t _threadNbr) const {
+        if constexpr (requires() { { _index.kmerLookup.k }; }) {
+            if (kmerLength > 0) {
+                _index.kmerLookup = KMerLookupTable{_index, kmerLength, _threadNbr};
+            }
+        }
+        if constexpr (requires() { { _index.isa.samplingRate }; }) {
+            if (isaSamplingRate > 0) {
+                _index.isa = SampledISA{_index, isaSamplingRate, _threadNbr};
+            }
+        }
+    }
+};
 }
 
 /**
  * Merges two FMIndices into a new one
+ *
+ * If any of the two has an inverse suffix array (isa), it is rebuilt on the merged index.
  */
 template <size_t SigmaLhs, template <size_t> typename StringLhs, size_t SigmaRhs, template <size_t> typename StringRhs, typename SuffixArray>
-auto merge(FMIndex<SigmaLhs, StringLhs, SuffixArray> const& lhs, FMIndex<SigmaRhs, StringRhs, SuffixArray> const& rhs) -> FMIndex<std::max(SigmaLhs, SigmaRhs), StringLhs, SuffixArray> {
-    auto R         = detail::computeInterleavingR(lhs.bwt, rhs.bwt);
-    auto mergedBwt = detail::mergeBwt(R, lhs.bwt, rhs.bwt);
-    auto annotatedArray = detail::mergeSparseArrays(R, lhs.annotatedArray, rhs.annotatedArray);
+auto merge(FMIndex<SigmaLhs, StringLhs, SuffixArray> const& lhs, FMIndex<SigmaRhs, StringRhs, SuffixArray> const& rhs, size_t threadNbr = 1) -> FMIndex<std::max(SigmaLhs, SigmaRhs), StringLhs, SuffixArray> {
+    auto R         = detail::computeInterleavingR(lhs.bwt, rhs.bwt, threadNbr);
+    auto mergedBwt = detail::mergeBwt(R, lhs.bwt, rhs.bwt, threadNbr);
+    auto annotatedArray = detail::mergeSparseArrays(R, lhs.annotatedArray, rhs.annotatedArray, threadNbr);
 
-    return {mergedBwt, std::move(annotatedArray)};
+    auto result = FMIndex<std::max(SigmaLhs, SigmaRhs), StringLhs, SuffixArray>{std::span<uint8_t const>{mergedBwt}, std::move(annotatedArray), threadNbr};
 
+    auto lookups = detail::Lookups{};
+    lookups.add(lhs);
+    lookups.add(rhs);
+    lookups.rebuild(result, threadNbr);
+    return result;
 }
 
 /**
  * Merges two bidirectional FMIndices into a new one
+ *
+ * If any of the two has a k-mer lookup table or an inverse suffix array (isa),
+ * it is rebuilt on the merged index, using the largest k and the smallest isa sampling rate.
  */
 template <size_t SigmaLhs, template <size_t> typename StrLhs, size_t SigmaRhs, template <size_t> typename StrRhs, typename SuffixArray>
-auto merge(BiFMIndex<SigmaLhs, StrLhs, SuffixArray> const& lhs, BiFMIndex<SigmaRhs, StrRhs, SuffixArray> const& rhs) -> BiFMIndex<std::max(SigmaLhs, SigmaRhs), StrLhs, SuffixArray> {
+auto merge(BiFMIndex<SigmaLhs, StrLhs, SuffixArray> const& lhs, BiFMIndex<SigmaRhs, StrRhs, SuffixArray> const& rhs, size_t threadNbr = 1) -> BiFMIndex<std::max(SigmaLhs, SigmaRhs), StrLhs, SuffixArray> {
     // compute R of fwd BWT and merge bwt and csa
-    auto R              = detail::computeInterleavingR(lhs.bwt, rhs.bwt);
-    auto mergedBwt      = detail::mergeBwt(R, lhs.bwt, rhs.bwt);
-    auto annotatedArray = detail::mergeSparseArrays(R, lhs.annotatedArray, rhs.annotatedArray);
+    auto R              = detail::computeInterleavingR(lhs.bwt, rhs.bwt, threadNbr);
+    auto mergedBwt      = detail::mergeBwt(R, lhs.bwt, rhs.bwt, threadNbr);
+    auto annotatedArray = detail::mergeSparseArrays(R, lhs.annotatedArray, rhs.annotatedArray, threadNbr);
 
     // compute R of rev BWT and merge BwtRev (reusing R to save on space)
-    R                 = detail::computeInterleavingR(lhs.bwtRev, rhs.bwtRev);
-    auto mergedBwtRev = detail::mergeBwt(R, lhs.bwtRev, rhs.bwtRev);
+    R                 = detail::computeInterleavingR(lhs.bwtRev, rhs.bwtRev, threadNbr);
+    auto mergedBwtRev = detail::mergeBwt(R, lhs.bwtRev, rhs.bwtRev, threadNbr);
+
+    auto result = BiFMIndex<std::max(SigmaLhs, SigmaRhs), StrLhs, SuffixArray>{std::span<uint8_t const>{mergedBwt}, std::span<uint8_t const>{mergedBwtRev}, std::move(annotatedArray), threadNbr};
+
+    auto lookups = detail::Lookups{};
+    lookups.add(lhs);
+    lookups.add(rhs);
+    lookups.rebuild(result, threadNbr);
+    return result;
+}
+
+/**
+ * Merges k FMIndices or BiFMIndices into a new one
+ *
+ * Neighbouring bwts are merged in a balanced tree, so every symbol takes part in
+ * O(log k) merges instead of O(k) when merging one index after the other.
+ * Along the way, a source id per merged row is maintained, from which the
+ * sampled suffix array is written exactly once.
+ * A k-mer lookup table or inverse suffix array (isa) of any of the indices is
+ * rebuilt on the merged index, same as for merging two indices.
+ *
+ * \param _indices indices to merge, seqIds are kept as they are (use seqOffset when creating the indices)
+ * \param _threadNbr number of threads
+ */
+template <typename Index>
+auto merge(std::vector<Index const*> const& _indices, size_t _threadNbr = 1) -> Index {
+    if (_indices.empty()) {
+        throw std::runtime_error{"merging requires at least one index"};
+    }
+    if (_indices.size() > std::numeric_limits<uint16_t>::max()) {
+        throw std::runtime_error{"can not merge more than 65535 indices at once"};
+    }
+
+    constexpr bool IsBidirectional = requires(Index const& index) {
+        { index.bwtRev.size() };
+    };
+    using String      = std::remove_cvref_t<decltype(_indices[0]->bwt)>;
+    using SparseArray = std::remove_cvref_t<decltype(_indices[0]->annotatedArray)>;
+
+    // source ids of each string of the current level
+    auto sourceIds = std::vector<std::vector<uint16_t>>{};
+    auto bwts      = std::vector<String const*>{};
+    auto arrays    = std::vector<SparseArray const*>{};
+    for (size_t i{0}; i < _indices.size(); ++i) {
+        sourceIds.emplace_back(_indices[i]->size(), static_cast<uint16_t>(i));
+        bwts.push_back(&_indices[i]->bwt);
+        arrays.push_back(&_indices[i]->annotatedArray);
+    }
+
+    auto bwt = detail::mergeStringsBalanced(bwts, _threadNbr, [&](size_t levelPos, detail::InterleavingR const& R) {
+        // merges of one level happen from left to right, all previous pairs of this level are already collapsed
+        auto lhs = levelPos / 2;
+        auto const& lhsIds = sourceIds[lhs];
+        auto const& rhsIds = sourceIds[lhs+1];
+        auto ids = std::vector<uint16_t>(R.size());
+        parallelFor(R.size(), _threadNbr, /*.chunkSize=*/1ull<<16, [&](size_t begin, size_t end) {
+            size_t idx2 = R.rank(begin);
+            size_t idx1 = begin - idx2;
+            for (size_t i{begin}; i < end; ++i) {
+                ids[i] = R[i] ? rhsIds[idx2++] : lhsIds[idx1++];
+            }
+        });
+        sourceIds[lhs] = std::move(ids);
+        sourceIds.erase(sourceIds.begin() + lhs + 1);
+    });
+    auto annotatedArray = detail::mergeSparseArraysKWay(sourceIds[0], arrays, _threadNbr);
+    decltype(sourceIds){}.swap(sourceIds); // memory can be released
+
+    auto result = Index{};
+    if constexpr (IsBidirectional) {
+        auto bwtRevs = std::vector<String const*>{};
+        for (auto index : _indices) {
+            bwtRevs.push_back(&index->bwtRev);
+        }
+        result.bwtRev = detail::mergeStringsBalanced(bwtRevs, _threadNbr, [](size_t, detail::InterleavingR const&) {});
+    }
+    result.bwt            = std::move(bwt);
+    result.C              = computeC(result.bwt);
+    result.annotatedArray = std::move(annotatedArray);
+
+    auto lookups = detail::Lookups{};
+    for (auto index : _indices) {
+        lookups.add(*index);
+    }
+    lookups.rebuild(result, _threadNbr);
+    return result;
+}
+
+/**
+ * Same as merge() above, for a list of owned indices
+ */
+template <typename Index>
+auto merge(std::vector<Index> const& _indices, size_t _threadNbr = 1) -> Index {
+    auto indices = std::vector<Index const*>{};
+    for (auto const& index : _indices) {
+        indices.push_back(&index);
+    }
+    return merge(indices, _threadNbr);
+}
 
-    return {mergedBwt, mergedBwtRev, std::move(annotatedArray)};
+namespace detail {
+/**
+ * Creates an FMIndex or BiFMIndex over a range of sequences, with seqIds starting at `_seqOffset`
+ */
+template <typename Index>
+auto createIndex(Sequences auto const& _input, size_t _samplingRate, size_t _threadNbr, size_t _seqOffset) -> Index {
+    constexpr bool IsBidirectional = requires(Index const& index) {
+        { index.bwtRev };
+    };
+    if constexpr (IsBidirectional) {
+        return Index{_input, _samplingRate, _threadNbr, /*.seqOffset=*/_seqOffset};
+    } else {
+        return Index{_input, _samplingRate, _threadNbr, /*.useDelimiters=*/true, /*.seqOffset=*/_seqOffset};
+    }
 }
 }
+
+/**
+ * Appends sequences to an existing index
+ *
+ * A small index over `_input` is build and merged into `_index`. The cost is
+ * linear in the size of the existing index, but avoids the suffix array
+ * construction of a full rebuild.
+ *
+ * \param _index        existing index
+ * \param _input        a list of sequences that should be added
+ * \param _samplingRate rate of the sampling of the new sequences
+ * \param _threadNbr    number of threads
+ * \param _seqOffset    seqId of the first appended sequence, usually the number of sequences in `_index`
+ * \return new index, containing the sequences of `_index` and `_input`, lookup tables of `_index` are rebuilt (see merge)
+ */
+template <typename Index>
+auto append(Index const& _index, Sequences auto const& _input, size_t _samplingRate, size_t _threadNbr, size_t _seqOffset) -> Index {
+    if (_input.size() == 0) {
+        return merge(std::vector<Index const*>{&_index}, _threadNbr);
+    }
+    auto delta = detail::createIndex<Index>(_input, _samplingRate, _threadNbr, _seqOffset);
+    return merge(_index, delta, _threadNbr);
+}
+
+/**
+ * Creates an index over sequences while bounding the memory used for suffix array construction
+ *
+ * The sequences are split into consecutive groups, whose text (and with it their
+ * suffix array) fits into `_memoryBudget` bytes. Each group is indexed on its own,
+ * using a sequence offset, so that all seqIds refer to positions in `_input`. The
+ * partial indices are combined with merge(). Equally sized indices are merged first,
+ * so every symbol takes part in O(log(groups)) merges.
+ * Sequences are never split, a single sequence larger than the budget forms its own group.
+ * An empty `_input` results in an empty, default constructed index.
+ * No k-mer lookup table or inverse suffix array is created, build them on the result if needed.
+ *
+ * \param _input        a list of sequences
+ * \param _samplingRate rate of the sampling
+ * \param _threadNbr    number of threads used per group
+ * \param _memoryBudget number of bytes the suffix array construction of one group may use
+ * \return the same index as when constructed directly, up to the order of identical suffixes of different sequences
+ */
+template <typename Index>
+auto createWithMemoryBudget(Sequences auto const& _input, size_t _samplingRate, size_t _threadNbr, size_t _memoryBudget) -> Index {
+    constexpr bool IsBidirectional = requires(Index const& index) {
+        { index.bwtRev };
+    };
+
+    // Bytes needed per symbol: text, bwt and suffix array, everything twice if forward and reverse are build concurrently
+    auto const bytesPerSymbol = (2 + sizeof(uint64_t)) * (IsBidirectional && _threadNbr > 1 ? 2 : 1);
+    auto const maxGroupSize   = std::max<size_t>(1, _memoryBudget / bytesPerSymbol);
+
+    auto createIndex = [&](size_t _begin, size_t _end) -> Index {
+        auto group = std::ranges::subrange(std::ranges::begin(_input) + _begin, std::ranges::begin(_input) + _end);
+        return detail::createIndex<Index>(group, _samplingRate, _threadNbr, /*.seqOffset=*/_begin);
+    };
+
+    // stack of partial indices and their merge level, levels are strictly decreasing
+    auto partials = std::vector<std::tuple<Index, size_t>>{};
+    auto mergeTop = [&]() {
+        auto [rhs, rhsLevel] = std::move(partials.back());
+        partials.pop_back();
+        auto& [lhs, lhsLevel] = partials.back();
+        lhs = merge(lhs, rhs, _threadNbr);
+        lhsLevel = std::max(lhsLevel, rhsLevel) + 1;
+    };
+
+    size_t begin{0};
+    while (begin < _input.size()) {
+        // collect sequences until the budget is reached
+        size_t end{begin};
+        size_t groupSize{0};
+        do {
+            groupSize += _input[end].size() + 1;
+            end += 1;
+        } while (end < _input.size() && groupSize + _input[end].size() + 1 <= maxGroupSize);
+
+        partials.emplace_back(createIndex(begin, end), 0);
+        while (partials.size() > 1 && std::get<1>(partials.back()) == std::get<1>(partials[partials.size()-2])) {
+            mergeTop();
+        }
+        begin = end;
+    }
+    if (partials.empty()) {
+        return Index{};
+    }
+    while (partials.size() > 1) {
+        mergeTop();
+    }
+    return std::move(std::get<0>(partials.back()));
+}
+
+}
@@ -3,8 +3,14 @@
 // SPDX-License-Identifier: BSD-3-Clause
 #pragma once
 
+#include "parallel.h"
+
+#include <algorithm>
+#include <cassert>
 #include <cstdint>
 #include <optional>
+#include <ranges>
+#include <span>
 #include <tuple>
 #include <vector>
 
@@ -154,4 +160,156 @@ void locateFMTree(index_t const& index, cursor_t cursor, CB const& cb, size_t sa
     }
 }
 
+namespace locate_batch_detail {
+
+/* Locates the rows `rowAt(begin)` to `rowAt(end-1)` and appends their
+ * (seqId, pos) to `_results`.
+ *
+ * Up to `_batchSize` LF walks are advanced interleaved. After each LF step the
+ * bwt and sampling entries of the next step are prefetched, so the cache misses
+ * of all walks overlap.
+ */
+template <typename index_t, typename rowAt_t>
+void locateInterleaved(index_t const& _index, size_t _begin, size_t _end, rowAt_t const& _rowAt, std::vector<std::tuple<size_t, size_t>>& _results, size_t _batchSize) {
+    auto const base = _results.size();
+    _results.resize(base + (_end - _begin));
+
+    // strings that have their own sampling information can't be interleaved
+    if constexpr (requires() { { _index.bwt.hasValue(size_t{}) }; }) {
+        for (size_t i{_begin}; i < _end; ++i) {
+            auto [seqId, pos, offset] = _index.locate(_rowAt(i));
+            _results[base + i - _begin] = {seqId, pos + offset};
+        }
+        return;
+    } else {
+        auto prefetch = [&](size_t idx) {
+            if constexpr (requires() { { _index.bwt.prefetch(idx) }; }) {
+                _index.bwt.prefetch(idx);
+            }
+            if constexpr (requires() { { _index.annotatedArray.prefetch(idx) }; }) {
+                _index.annotatedArray.prefetch(idx);
+            }
+        };
+
+        struct Walk {
+            size_t resultIdx; // position inside _results
+            size_t idx;       // current row
+            size_t steps;     // number of LF steps taken
+        };
+        auto walks = std::vector<Walk>{};
+        walks.reserve(_batchSize);
+        size_t next = _begin;
+
+        auto loadNext = [&](Walk& walk) -> bool {
+            if (next == _end) return false;
+            walk = Walk{base + next - _begin, _rowAt(next), 0};
+            prefetch(walk.idx);
+            ++next;
+            return true;
+        };
+
+        while (walks.size() < _batchSize) {
+            walks.emplace_back();
+            if (!loadNext(walks.back())) {
+                walks.pop_back();
+                break;
+            }
+        }
+
+        while (!walks.empty()) {
+            for (size_t i{0}; i < walks.size();) {
+                auto& walk = walks[i];
+                if (auto opt = _index.single_locate_step(walk.idx); !opt) {
+                    if constexpr (requires() { { _index.bwt.rank_symbol(size_t{}) }; }) {
+                        walk.idx = _index.bwt.rank_symbol(walk.idx);
+                    } else {
+                        auto symb = _index.bwt.symbol(walk.idx);
+                        walk.idx = _index.bwt.rank(walk.idx, symb) + _index.C[symb];
+                    }
+                    walk.steps += 1;
+                    prefetch(walk.idx);
+                    ++i;
+                    continue;
+                } else {
+                    auto [seqId, pos] = *opt;
+                    _results[walk.resultIdx] = {seqId, pos + walk.steps};
+                }
+                if (loadNext(walk)) {
+                    ++i;
+                    continue;
+                }
+                // no rows left, shrink the batch
+                walk = walks.back();
+                walks.pop_back();
+            }
+        }
+    }
+}
+
+}
+
+/** Locates many rows of the suffix array at once
+ *
+ * LF walks of multiple rows are interleaved with prefetching (see `_batchSize`)
+ * and the rows are distributed over `_threadNbr` threads.
+ *
+ * \param _index     the index, its sampled entries must be (seqId, pos) pairs
+ * \param _rows      rows of the suffix array that should be located
+ * \param _threadNbr number of threads
+ * \param _batchSize number of rows located interleaved by one thread
+ * \return a (seqId, pos) pair for each row, in the order of `_rows`
+ */
+template <typename index_t>
+auto locateBatch(index_t const& _index, std::span<size_t const> _rows, size_t _threadNbr = 1, size_t _batchSize = 32) -> std::vector<std::tuple<size_t, size_t>> {
+    static_assert(std::tuple_size_v<typename index_t::ADEntry> == 2, "locateBatch requires (seqId, pos) entries");
+
+    auto results = std::vector<std::tuple<size_t, size_t>>{};
+    results.reserve(_rows.size());
+    auto rowAt = [&](size_t i) { return _rows[i]; };
+    parallelBatch<std::tuple<size_t, size_t>>(_rows.size(), _threadNbr, /*.chunkSize=*/4096, [&](size_t begin, size_t end, auto& buffer) {
+        locate_batch_detail::locateInterleaved(_index, begin, end, rowAt, buffer, _batchSize);
+    }, [&](auto const& buffer) {
+        results.insert(results.end(), buffer.begin(), buffer.end());
+    });
+    return results;
+}
+
+/** Locates all rows covered by multiple cursors
+ *
+ * Same as locateBatch over rows, but takes the rows `[cursor.lb, cursor.lb+cursor.len)`
+ * of each cursor. Large intervals are split across threads.
+ *
+ * \return a (seqId, pos) pair for each row, cursor after cursor
+ */
+template <typename index_t, std::ranges::random_access_range cursors_t>
+    requires requires(std::ranges::range_value_t<cursors_t> c) {
+        { c.lb };
+        { c.len };
+    }
+auto locateBatch(index_t const& _index, cursors_t const& _cursors, size_t _threadNbr = 1, size_t _batchSize = 32) -> std::vector<std::tuple<size_t, size_t>> {
+    static_assert(std::tuple_size_v<typename index_t::ADEntry> == 2, "locateBatch requires (seqId, pos) entries");
+
+    // first result index of each cursor
+    auto offsets = std::vector<size_t>{};
+    offsets.reserve(_cursors.size()+1);
+    offsets.push_back(0);
+    for (auto const& cursor : _cursors) {
+        offsets.push_back(offsets.back() + cursor.len);
+    }
+    auto rowAt = [&](size_t i) {
+        auto iter = std::ranges::upper_bound(offsets, i) - 1;
+        auto const& cursor = _cursors[static_cast<size_t>(std::distance(offsets.begin(), iter))];
+        return cursor.lb + (i - *iter);
+    };
+
+    auto results = std::vector<std::tuple<size_t, size_t>>{};
+    results.reserve(offsets.back());
+    parallelBatch<std::tuple<size_t, size_t>>(offsets.back(), _threadNbr, /*.chunkSize=*/4096, [&](size_t begin, size_t end, auto& buffer) {
+        locate_batch_detail::locateInterleaved(_index, begin, end, rowAt, buffer, _batchSize);
+    }, [&](auto const& buffer) {
+        results.insert(results.end(), buffer.begin(), buffer.end());
+    });
+    return results;
+}
+
 }
@@ -0,0 +1,326 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#if defined(__linux__)
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+/**
+ * Placement of the index arrays in memory
+ *
+ * Huge pages: the large arrays of an index (bwt bits and rank blocks, sparse array documents,
+ * dense vectors, ...) are allocated by the default allocator or are mapped from a file
+ * (loadIndexMMap). `adviseHugePages(index)` walks all arrays of an index via its `serialize`
+ * function and asks the kernel to back them by transparent huge pages (2MB), which reduces
+ * TLB misses of rank heavy searches on multi-GB indices. It works for built and for mmap-loaded
+ * indices (the latter requires a kernel supporting huge pages for file mappings).
+ *
+ * NUMA: `NumaReplicas` creates one copy of an index per NUMA node, search threads
+ * pick the copy of the node they are currently running on via `local()`.
+ */
+namespace fmc {
+
+struct HugePagePolicy {
+    size_t pageSize{size_t{1} << 21}; // size of a huge page, only fully covered pages are advised
+    size_t minBytes{size_t{1} << 21}; // arrays smaller than this are skipped
+    bool   collapse{false};           // synchronously collapse the pages (MADV_COLLAPSE) instead of waiting for khugepaged
+};
+
+struct HugePageReport {
+    size_t arrays{};  // number of advised arrays
+    size_t bytes{};   // number of advised bytes
+    size_t failed{};  // number of arrays the kernel refused (or huge pages are not supported)
+};
+
+namespace detail {
+
+/* Archive-like visitor, reports every array that owns heap (or mapped) memory to `cb`
+ *
+ * Members are discovered the same way cereal discovers them: via `serialize(ar)` or `save(ar)`.
+ */
+template <typename cb_t>
+struct ArrayVisitor {
+    cb_t& cb;
+
+    template <typename... Ts>
+    void operator()(Ts const&... _values) {
+        (visit(_values), ...);
+    }
+
+    template <typename T>
+    void visit(T const& _value) {
+        if constexpr (std::ranges::contiguous_range<T const> && std::ranges::sized_range<T const>) {
+            using value_t = std::ranges::range_value_t<T const>;
+            auto ptr   = reinterpret_cast<std::byte const*>(std::ranges::data(_value));
+            auto bytes = std::ranges::size(_value) * sizeof(value_t);
+            auto self  = reinterpret_cast<std::byte const*>(&_value);
+
+            // skip inline storage, e.g. std::array
+            bool isInline = (ptr >= self && ptr < self + sizeof(T));
+            if (!isInline && bytes > 0) {
+                cb(ptr, bytes);
+            }
+            if constexpr (!std::is_trivially_copyable_v<value_t>) {
+                for (auto const& v : _value) {
+                    visit(v);
+                }
+            }
+        } else if constexpr (requires(T const& t, ArrayVisitor& ar) { t.serialize(ar); }) {
+            _value.serialize(*this);
+        } else if constexpr (requires(T const& t, ArrayVisitor& ar) { t.save(ar); }) {
+            _value.save(*this);
+        } else if constexpr (requires() { std::tuple_size<T>::value; }) {
+            std::apply([&](auto const&... v) { (visit(v), ...); }, _value);
+        } else if constexpr (requires(T const& t) { t.has_value(); *t; }) {
+            if (_value.has_value()) {
+                visit(*_value);
+            }
+        }
+        // everything else does not own any large memory
+    }
+};
+
+}
+
+/**
+ * Calls `_cb(std::byte const* ptr, size_t bytes)` for every array owned by `_obj`
+ *
+ * \param _obj any object with a cereal-like `serialize` function, e.g. an index
+ */
+template <typename T, typename cb_t>
+void forEachArray(T const& _obj, cb_t&& _cb) {
+    auto visitor = detail::ArrayVisitor<std::remove_reference_t<cb_t>>{_cb};
+    visitor.visit(_obj);
+}
+
+/**
+ * Advises the kernel to back `[_ptr, _ptr+_bytes)` by huge pages
+ *
+ * Only the huge pages fully inside the range are advised, memory at the borders may be shared
+ * with other allocations.
+ * \return false if the range is too small or the kernel refused the advice
+ */
+inline bool adviseHugePages(void const* _ptr, size_t _bytes, HugePagePolicy const& _policy = {}) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    auto begin = reinterpret_cast<uintptr_t>(_ptr);
+    auto end   = begin + _bytes;
+    begin = (begin + _policy.pageSize - 1) / _policy.pageSize * _policy.pageSize;
+    end   = end / _policy.pageSize * _policy.pageSize;
+    if (_bytes < _policy.minBytes || begin >= end) return false;
+
+    auto addr = reinterpret_cast<void*>(begin);
+    if (madvise(addr, end - begin, MADV_HUGEPAGE) != 0) return false;
+    #if defined(MADV_COLLAPSE)
+    if (_policy.collapse && madvise(addr, end - begin, MADV_COLLAPSE) != 0) return false;
+    #endif
+    return true;
+#else
+    (void)_ptr; (void)_bytes; (void)_policy;
+    return false;
+#endif
+}
+
+/**
+ * Advises the kernel to back all large arrays of `_index` by huge pages
+ *
+ * Call it after building or loading an index (loadIndex or loadIndexMMap). All serialized
+ * members are covered, and the optional kmerLookup and isa tables, which are not serialized.
+ */
+template <typename Index>
+auto adviseHugePages(Index const& _index, HugePagePolicy const& _policy = {}) -> HugePageReport {
+    auto report = HugePageReport{};
+    auto advise = [&](std::byte const* ptr, size_t bytes) {
+        if (bytes < _policy.minBytes) return;
+        if (adviseHugePages(ptr, bytes, _policy)) {
+            report.arrays += 1;
+            report.bytes  += bytes;
+        } else {
+            report.failed += 1;
+        }
+    };
+    forEachArray(_index, advise);
+    if constexpr (requires { _index.kmerLookup; }) {
+        forEachArray(_index.kmerLookup, advise);
+    }
+    if constexpr (requires { _index.isa; }) {
+        forEachArray(_index.isa, advise);
+    }
+    return report;
+}
+
+namespace numa {
+
+//!\brief parses a cpu list of the form "0-3,8,10-11"
+inline auto parseCpuList(std::string const& _list) -> std::vector<size_t> {
+    auto cpus = std::vector<size_t>{};
+    for (auto part : _list | std::views::split(',')) {
+        auto str = std::string(part.begin(), part.end());
+        std::erase_if(str, [](char c) { return c == ' ' || c == '\n'; });
+        if (str.empty()) continue;
+        auto dash  = str.find('-');
+        auto first = std::stoul(str.substr(0, dash));
+        auto last  = (dash == std::string::npos) ? first : std::stoul(str.substr(dash+1));
+        for (auto cpu{first}; cpu <= last; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+struct Topology {
+    std::vector<std::vector<size_t>> cpusOfNode; // cpus of each (online) node
+
+    //!\brief topology of this machine, a single node without cpus if it can not be determined
+    static auto detect() -> Topology {
+        auto topology = Topology{};
+#if defined(__linux__)
+        auto readFile = [](std::string const& path) -> std::optional<std::string> {
+            auto ifs = std::ifstream{path};
+            if (!ifs) return std::nullopt;
+            auto str = std::string{};
+            std::getline(ifs, str);
+            return str;
+        };
+        if (auto online = readFile("/sys/devices/system/node/online")) {
+            for (auto node : parseCpuList(*online)) {
+                auto cpus = readFile("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+                if (!cpus) continue;
+                auto list = parseCpuList(*cpus);
+                if (list.empty()) continue; // memory-only node
+                topology.cpusOfNode.push_back(std::move(list));
+            }
+        }
+#endif
+        if (topology.cpusOfNode.empty()) {
+            topology.cpusOfNode.emplace_back();
+        }
+        return topology;
+    }
+
+    size_t nodeCount() const {
+        return cpusOfNode.size();
+    }
+
+    //!\brief node of `_cpu`, 0 if unknown
+    size_t nodeOfCpu(size_t _cpu) const {
+        for (size_t node{0}; node < cpusOfNode.size(); ++node) {
+            if (std::ranges::find(cpusOfNode[node], _cpu) != cpusOfNode[node].end()) {
+                return node;
+            }
+        }
+        return 0;
+    }
+};
+
+//!\brief pins the calling thread to `_cpus`, returns false on failure
+inline bool bindThread(std::vector<size_t> const& _cpus) {
+#if defined(__linux__)
+    if (_cpus.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (auto cpu : _cpus) {
+        if (cpu < CPU_SETSIZE) CPU_SET(cpu, &set);
+    }
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+    (void)_cpus;
+    return false;
+#endif
+}
+
+//!\brief cpu the calling thread is running on, 0 if unknown
+inline size_t currentCpu() {
+#if defined(__linux__)
+    auto cpu = sched_getcpu();
+    return cpu < 0 ? 0 : size_t(cpu);
+#else
+    return 0;
+#endif
+}
+
+}
+
+/**
+ * One copy of an index per NUMA node
+ *
+ * Each copy is created by `_create()` on a thread that is pinned to the cpus of its node.
+ * With the default (first touch) memory policy, all memory written during the creation
+ * is allocated on that node. `_create` must therefore build or read the index, e.g. via
+ * `loadIndex`. Copies created by `loadIndexMMap` share the page cache and are not node local.
+ *
+ * Usage:
+ *   auto replicas = fmc::NumaReplicas<Index>{[&]() { return fmc::loadIndex<Index>(path); }};
+ *   // inside each search thread:
+ *   auto const& index = replicas.local();
+ */
+template <typename Index>
+class NumaReplicas {
+    numa::Topology                      topology;
+    std::vector<std::unique_ptr<Index>> replicas;
+
+public:
+    /**
+     * \param _create    callback returning a new index
+     * \param _replicate create one copy per node, if false a single copy is created on the calling thread
+     * \param _topology  nodes and their cpus
+     */
+    template <typename create_t>
+    explicit NumaReplicas(create_t const& _create, bool _replicate = true, numa::Topology _topology = numa::Topology::detect())
+        : topology{std::move(_topology)}
+    {
+        if (!_replicate || topology.nodeCount() <= 1) {
+            replicas.push_back(std::make_unique<Index>(_create()));
+            return;
+        }
+        replicas.resize(topology.nodeCount());
+        auto errors  = std::vector<std::exception_ptr>(topology.nodeCount());
+        auto threads = std::vector<std::jthread>{};
+        for (size_t node{0}; node < topology.nodeCount(); ++node) {
+            threads.emplace_back([&, node]() {
+                try {
+                    numa::bindThread(topology.cpusOfNode[node]); // if binding fails, the copy is still valid, just not local
+                    replicas[node] = std::make_unique<Index>(_create());
+                } catch (...) {
+                    errors[node] = std::current_exception();
+                }
+            });
+        }
+        threads.clear();
+        for (auto const& e : errors) {
+            if (e) std::rethrow_exception(e);
+        }
+    }
+
+    size_t size() const {
+        return replicas.size();
+    }
+
+    auto operator[](size_t _node) const -> Index const& {
+        return *replicas[_node];
+    }
+
+    //!\brief copy of the node the calling thread is currently running on
+    auto local() const -> Index const& {
+        if (replicas.size() == 1) return *replicas[0];
+        auto node = topology.nodeOfCpu(numa::currentCpu());
+        return *replicas[std::min(node, replicas.size()-1)];
+    }
+};
+
+}
@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace fmc {
+
+/** Processes the entries [0, _size) in chunks on multiple threads
+ *
+ * The range is split into chunks of `_chunkSize` entries. Each worker thread
+ * repeatedly grabs the next unprocessed chunk, so threads that finish early
+ * take over work that would otherwise wait behind a slow chunk.
+ * A chunk is processed by calling `_process(begin, end, buffer)`, which appends
+ * its results to `buffer`.
+ * Finished buffers are handed to `_report(buffer)` strictly in chunk order and
+ * never concurrently. The sequence of reported results is therefore identical
+ * to a single threaded run.
+ * A worker does not start a chunk that lies `4 * _threadNbr` or more chunks
+ * ahead of the next chunk to report, it waits instead. This bounds the number
+ * of finished buffers that are held back because an earlier chunk is slow.
+ *
+ * Each worker is a dedicated thread that lives until all chunks are done, so
+ * `thread_local` caches (e.g. getCachedSearchScheme) stay warm across chunks.
+ *
+ * \param _size      number of entries
+ * \param _threadNbr number of threads, a value of 0 or 1 runs on the calling thread
+ * \param _chunkSize number of entries processed in one piece
+ * \param _process   callback `(size_t begin, size_t end, std::vector<Result>& buffer)`
+ * \param _report    callback `(std::vector<Result> const& buffer)`
+ */
+template <typename Result, typename process_t, typename report_t>
+void parallelBatch(size_t _size, size_t _threadNbr, size_t _chunkSize, process_t const& _process, report_t&& _report) {
+    if (_size == 0) return;
+    _chunkSize = std::max<size_t>(1, _chunkSize);
+
+    auto const chunkCt = (_size + _chunkSize - 1) / _chunkSize;
+    _threadNbr = std::clamp<size_t>(_threadNbr, 1, chunkCt);
+
+    auto chunkRange = [&](size_t chunk) {
+        auto begin = chunk * _chunkSize;
+        auto end   = std::min(begin + _chunkSize, _size);
+        return std::make_tuple(begin, end);
+    };
+
+    if (_threadNbr == 1) {
+        auto buffer = std::vector<Result>{};
+        for (size_t chunk{0}; chunk < chunkCt; ++chunk) {
+            auto [begin, end] = chunkRange(chunk);
+            buffer.clear();
+            _process(begin, end, buffer);
+            _report(std::as_const(buffer));
+        }
+        return;
+    }
+
+    auto const window = 4 * _threadNbr; // maximal number of chunks a worker may run ahead
+    auto nextChunk  = std::atomic<size_t>{0};
+    auto mutex      = std::mutex{};
+    auto reported   = std::condition_variable{};
+    auto finished   = std::vector<std::optional<std::vector<Result>>>(chunkCt);
+    auto nextReport = size_t{0};
+    auto error      = std::exception_ptr{};
+
+    auto worker = [&]() {
+        try {
+            for (auto chunk = nextChunk++; chunk < chunkCt; chunk = nextChunk++) {
+                // the chunk at nextReport is always owned by a running worker, so this can not deadlock
+                if (chunk >= window) {
+                    auto lock = std::unique_lock{mutex};
+                    reported.wait(lock, [&]() { return chunk < nextReport + window || error; });
+                    if (error) break;
+                }
+                auto [begin, end] = chunkRange(chunk);
+                auto buffer = std::vector<Result>{};
+                _process(begin, end, buffer);
+
+                auto lock = std::scoped_lock{mutex};
+                finished[chunk] = std::move(buffer);
+                // forward all chunks that are complete and next in line
+                while (nextReport < chunkCt && finished[nextReport]) {
+                    _report(std::as_const(*finished[nextReport]));
+                    finished[nextReport].reset();
+                    ++nextReport;
+                }
+                reported.notify_all();
+            }
+        } catch(...) {
+            {
+                auto lock = std::scoped_lock{mutex};
+                if (!error) {
+                    error = std::current_exception();
+                }
+                nextChunk = chunkCt; // stop all other workers
+            }
+            reported.notify_all();
+        }
+    };
+
+    auto threads = std::vector<std::thread>{};
+    threads.reserve(_threadNbr-1);
+    for (size_t i{1}; i < _threadNbr; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+/** Calls `_process(begin, end)` for chunks of [0, _size) on multiple threads
+ *
+ * Same scheduling as parallelBatch, but without collecting results. Chunks
+ * may be processed in any order and concurrently.
+ *
+ * \param _size      number of entries
+ * \param _threadNbr number of threads, a value of 0 or 1 runs on the calling thread
+ * \param _chunkSize number of entries processed in one piece
+ * \param _process   callback `(size_t begin, size_t end)`
+ */
+template <typename process_t>
+void parallelFor(size_t _size, size_t _threadNbr, size_t _chunkSize, process_t const& _process) {
+    if (_size == 0) return;
+    _chunkSize = std::max<size_t>(1, _chunkSize);
+
+    auto const chunkCt = (_size + _chunkSize - 1) / _chunkSize;
+    _threadNbr = std::clamp<size_t>(_threadNbr, 1, chunkCt);
+
+    if (_threadNbr == 1) {
+        _process(size_t{0}, _size);
+        return;
+    }
+
+    auto nextChunk = std::atomic<size_t>{0};
+    auto mutex     = std::mutex{};
+    auto error     = std::exception_ptr{};
+
+    auto worker = [&]() {
+        try {
+            for (auto chunk = nextChunk++; chunk < chunkCt; chunk = nextChunk++) {
+                auto begin = chunk * _chunkSize;
+                auto end   = std::min(begin + _chunkSize, _size);
+                _process(begin, end);
+            }
+        } catch(...) {
+            auto lock = std::scoped_lock{mutex};
+            if (!error) {
+                error = std::current_exception();
+            }
+            nextChunk = chunkCt; // stop all other workers
+        }
+    };
+
+    auto threads = std::vector<std::thread>{};
+    threads.reserve(_threadNbr-1);
+    for (size_t i{1}; i < _threadNbr; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto& t : threads) {
+        t.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+}
@@ -0,0 +1,339 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <bit>
+#include <bitset>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+
+#if !defined(FMC_DISABLE_RANK_KERNELS) && defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#   define FMC_RANK_KERNELS_X86 1
+#   include <immintrin.h>
+#else
+#   define FMC_RANK_KERNELS_X86 0
+#endif
+
+/**
+ * Hand written rank kernels
+ *
+ * The kernels operate on blocks of 64bit words:
+ *  - andCount:        popcount(a & mask)
+ *  - orAndNotCount:   out = l | (r & ~bits); popcount(out & mask)
+ *                     (the inner step of all_ranks_dual, a single VPTERNLOG)
+ *
+ * Available kernels:
+ *  - AVX512VPOPCNTDQ: Ice Lake, Zen 4 and newer (VPTERNLOG + VPOPCNTQ)
+ *  - AVX512BW:        Skylake-X (VPTERNLOG + nibble lookup popcount)
+ *  - AVX2:            nibble lookup popcount
+ *  - Popcnt:          scalar loop compiled for the popcnt instruction
+ *  - Scalar:          std::popcount, used on all other platforms
+ *
+ * A single masked popcount of a 512bit block is fastest with scalar popcnt
+ * instructions, the reduction of a vector register costs more than it saves.
+ * The fused orAndNotCount profits from vector registers.
+ *
+ * If the compiler already targets the instructions of the best kernel (e.g. via
+ * `-march=native`), the kernel is chosen at compile time and inlined:
+ *  - andCount uses std::bitset if `__POPCNT__` is defined
+ *  - orAndNotCount uses the AVX512VPOPCNTDQ, AVX512BW or AVX2 kernel if
+ *    `__AVX512VPOPCNTDQ__`, `__AVX512BW__` or `__AVX2__` is defined
+ * Otherwise (e.g. a generic x86-64 build) the kernel is selected at load time via
+ * cpuid and called through a function pointer.
+ *
+ * Defining FMC_DISABLE_RANK_KERNELS disables all kernels and always uses the std::bitset code.
+ */
+namespace fmc::rank_kernels {
+
+enum class Kernel { Scalar, Popcnt, AVX2, AVX512BW, AVX512VPOPCNTDQ };
+
+using AndCount_t      = size_t(*)(uint64_t const* _a, uint64_t const* _mask, size_t _words);
+using OrAndNotCount_t = size_t(*)(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words);
+
+inline size_t andCountScalar(uint64_t const* _a, uint64_t const* _mask, size_t _words) {
+    size_t count{};
+    for (size_t i{0}; i < _words; ++i) {
+        count += std::popcount(_a[i] & _mask[i]);
+    }
+    return count;
+}
+
+inline size_t orAndNotCountScalar(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words) {
+    size_t count{};
+    for (size_t i{0}; i < _words; ++i) {
+        _out[i] = _l[i] | (_r[i] & ~_bits[i]);
+        count += std::popcount(_out[i] & _mask[i]);
+    }
+    return count;
+}
+
+#if FMC_RANK_KERNELS_X86
+__attribute__((target("popcnt")))
+inline size_t andCountPopcnt(uint64_t const* _a, uint64_t const* _mask, size_t _words) {
+    size_t count{};
+    for (size_t i{0}; i < _words; ++i) {
+        count += std::popcount(_a[i] & _mask[i]);
+    }
+    return count;
+}
+
+__attribute__((target("popcnt")))
+inline size_t orAndNotCountPopcnt(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words) {
+    size_t count{};
+    for (size_t i{0}; i < _words; ++i) {
+        _out[i] = _l[i] | (_r[i] & ~_bits[i]);
+        count += std::popcount(_out[i] & _mask[i]);
+    }
+    return count;
+}
+
+namespace detail {
+// popcount of each byte via a 4bit lookup table, summed up into 64bit lanes
+__attribute__((target("avx2")))
+inline __m256i popcount256(__m256i v) {
+    auto const lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                         0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+    auto const low = _mm256_set1_epi8(0x0f);
+    auto lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(v, low));
+    auto hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi16(v, 4), low));
+    return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+}
+
+__attribute__((target("avx2")))
+inline size_t hsum256(__m256i v) {
+    auto s = _mm_add_epi64(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+    return _mm_cvtsi128_si64(s) + _mm_extract_epi64(s, 1);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline __m512i popcount512bw(__m512i v) {
+    auto const lookup = _mm512_set4_epi32(0x04030302, 0x03020201, 0x03020201, 0x02010100);
+    auto const low = _mm512_set1_epi8(0x0f);
+    auto lo = _mm512_shuffle_epi8(lookup, _mm512_and_si512(v, low));
+    auto hi = _mm512_shuffle_epi8(lookup, _mm512_and_si512(_mm512_srli_epi16(v, 4), low));
+    return _mm512_sad_epu8(_mm512_add_epi8(lo, hi), _mm512_setzero_si512());
+}
+
+// not _mm512_reduce_add_epi64, gcc 12 reports its internal undefined vector with -Wuninitialized
+__attribute__((target("avx512f")))
+inline size_t hsum512(__m512i v) {
+    alignas(64) uint64_t lanes[8];
+    _mm512_store_si512(lanes, v);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + lanes[4] + lanes[5] + lanes[6] + lanes[7];
+}
+}
+
+__attribute__((target("avx2")))
+inline size_t andCountAVX2(uint64_t const* _a, uint64_t const* _mask, size_t _words) {
+    auto acc = _mm256_setzero_si256();
+    size_t i{0};
+    for (; i + 4 <= _words; i += 4) {
+        auto a = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_a + i));
+        auto m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_mask + i));
+        acc = _mm256_add_epi64(acc, detail::popcount256(_mm256_and_si256(a, m)));
+    }
+    return detail::hsum256(acc) + andCountScalar(_a + i, _mask + i, _words - i);
+}
+
+__attribute__((target("avx2")))
+inline size_t orAndNotCountAVX2(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words) {
+    auto acc = _mm256_setzero_si256();
+    size_t i{0};
+    for (; i + 4 <= _words; i += 4) {
+        auto l = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_l + i));
+        auto r = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_r + i));
+        auto b = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_bits + i));
+        auto m = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(_mask + i));
+        auto o = _mm256_or_si256(l, _mm256_andnot_si256(b, r));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(_out + i), o);
+        acc = _mm256_add_epi64(acc, detail::popcount256(_mm256_and_si256(o, m)));
+    }
+    return detail::hsum256(acc) + orAndNotCountScalar(_l + i, _r + i, _bits + i, _mask + i, _out + i, _words - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline size_t andCountAVX512BW(uint64_t const* _a, uint64_t const* _mask, size_t _words) {
+    auto acc = _mm512_setzero_si512();
+    size_t i{0};
+    for (; i + 8 <= _words; i += 8) {
+        auto a = _mm512_loadu_si512(_a + i);
+        auto m = _mm512_loadu_si512(_mask + i);
+        acc = _mm512_add_epi64(acc, detail::popcount512bw(_mm512_and_si512(a, m)));
+    }
+    return detail::hsum512(acc) + andCountScalar(_a + i, _mask + i, _words - i);
+}
+
+__attribute__((target("avx512f,avx512bw")))
+inline size_t orAndNotCountAVX512BW(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words) {
+    auto acc = _mm512_setzero_si512();
+    size_t i{0};
+    for (; i + 8 <= _words; i += 8) {
+        auto l = _mm512_loadu_si512(_l + i);
+        auto r = _mm512_loadu_si512(_r + i);
+        auto b = _mm512_loadu_si512(_bits + i);
+        auto m = _mm512_loadu_si512(_mask + i);
+        auto o = _mm512_ternarylogic_epi64(l, r, b, 0xf4); // l | (r & ~b)
+        _mm512_storeu_si512(_out + i, o);
+        acc = _mm512_add_epi64(acc, detail::popcount512bw(_mm512_and_si512(o, m)));
+    }
+    return detail::hsum512(acc) + orAndNotCountScalar(_l + i, _r + i, _bits + i, _mask + i, _out + i, _words - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline size_t andCountAVX512VPOPCNTDQ(uint64_t const* _a, uint64_t const* _mask, size_t _words) {
+    auto acc = _mm512_setzero_si512();
+    size_t i{0};
+    for (; i + 8 <= _words; i += 8) {
+        auto a = _mm512_loadu_si512(_a + i);
+        auto m = _mm512_loadu_si512(_mask + i);
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(a, m)));
+    }
+    return detail::hsum512(acc) + andCountScalar(_a + i, _mask + i, _words - i);
+}
+
+__attribute__((target("avx512f,avx512vpopcntdq")))
+inline size_t orAndNotCountAVX512VPOPCNTDQ(uint64_t const* _l, uint64_t const* _r, uint64_t const* _bits, uint64_t const* _mask, uint64_t* _out, size_t _words) {
+    auto acc = _mm512_setzero_si512();
+    size_t i{0};
+    for (; i + 8 <= _words; i += 8) {
+        auto l = _mm512_loadu_si512(_l + i);
+        auto r = _mm512_loadu_si512(_r + i);
+        auto b = _mm512_loadu_si512(_bits + i);
+        auto m = _mm512_loadu_si512(_mask + i);
+        auto o = _mm512_ternarylogic_epi64(l, r, b, 0xf4); // l | (r & ~b)
+        _mm512_storeu_si512(_out + i, o);
+        acc = _mm512_add_epi64(acc, _mm512_popcnt_epi64(_mm512_and_si512(o, m)));
+    }
+    return detail::hsum512(acc) + orAndNotCountScalar(_l + i, _r + i, _bits + i, _mask + i, _out + i, _words - i);
+}
+#endif
+
+//!\brief true if `_kernel` can be executed on this cpu
+inline bool isSupported(Kernel _kernel) {
+    if (_kernel == Kernel::Scalar) return true;
+#if FMC_RANK_KERNELS_X86
+    __builtin_cpu_init();
+    switch (_kernel) {
+        case Kernel::Popcnt:          return __builtin_cpu_supports("popcnt");
+        case Kernel::AVX2:            return __builtin_cpu_supports("avx2");
+        case Kernel::AVX512BW:        return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw");
+        case Kernel::AVX512VPOPCNTDQ: return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512vpopcntdq");
+        default: break;
+    }
+#endif
+    return false;
+}
+
+//!\brief best kernel for andCount supported by this cpu
+inline auto detectAndCountKernel() -> Kernel {
+    return isSupported(Kernel::Popcnt) ? Kernel::Popcnt : Kernel::Scalar;
+}
+
+//!\brief best kernel for orAndNotCount supported by this cpu
+inline auto detectOrAndNotCountKernel() -> Kernel {
+    for (auto k : {Kernel::AVX512VPOPCNTDQ, Kernel::AVX512BW, Kernel::AVX2, Kernel::Popcnt}) {
+        if (isSupported(k)) return k;
+    }
+    return Kernel::Scalar;
+}
+
+inline auto selectAndCount(Kernel _kernel) -> AndCount_t {
+#if FMC_RANK_KERNELS_X86
+    switch (_kernel) {
+        case Kernel::Popcnt:          return andCountPopcnt;
+        case Kernel::AVX2:            return andCountAVX2;
+        case Kernel::AVX512BW:        return andCountAVX512BW;
+        case Kernel::AVX512VPOPCNTDQ: return andCountAVX512VPOPCNTDQ;
+        default: break;
+    }
+#endif
+    (void)_kernel;
+    return andCountScalar;
+}
+
+inline auto selectOrAndNotCount(Kernel _kernel) -> OrAndNotCount_t {
+#if FMC_RANK_KERNELS_X86
+    switch (_kernel) {
+        case Kernel::Popcnt:          return orAndNotCountPopcnt;
+        case Kernel::AVX2:            return orAndNotCountAVX2;
+        case Kernel::AVX512BW:        return orAndNotCountAVX512BW;
+        case Kernel::AVX512VPOPCNTDQ: return orAndNotCountAVX512VPOPCNTDQ;
+        default: break;
+    }
+#endif
+    (void)_kernel;
+    return orAndNotCountScalar;
+}
+
+// kernels chosen at compile time, see above
+#if FMC_RANK_KERNELS_X86 && !defined(__POPCNT__)
+#   define FMC_RANK_KERNELS_DISPATCH_AND_COUNT 1
+#else
+#   define FMC_RANK_KERNELS_DISPATCH_AND_COUNT 0
+#endif
+#if FMC_RANK_KERNELS_X86 && defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#   define FMC_RANK_KERNELS_STATIC_OR_AND_NOT_COUNT orAndNotCountAVX512VPOPCNTDQ
+#elif FMC_RANK_KERNELS_X86 && defined(__AVX512F__) && defined(__AVX512BW__)
+#   define FMC_RANK_KERNELS_STATIC_OR_AND_NOT_COUNT orAndNotCountAVX512BW
+#elif FMC_RANK_KERNELS_X86 && defined(__AVX2__)
+#   define FMC_RANK_KERNELS_STATIC_OR_AND_NOT_COUNT orAndNotCountAVX2
+#endif
+
+// kernels selected at load time, only used if no kernel was chosen at compile time
+inline Kernel const activeAndCountKernel         = detectAndCountKernel();
+inline Kernel const activeOrAndNotCountKernel    = detectOrAndNotCountKernel();
+inline AndCount_t const activeAndCount           = selectAndCount(activeAndCountKernel);
+inline OrAndNotCount_t const activeOrAndNotCount = selectOrAndNotCount(activeOrAndNotCountKernel);
+
+// std::bitset<N> can be viewed as an array of 64bit words (true for libstdc++ and libc++ on x86_64)
+template <size_t N>
+constexpr bool UsableFor = FMC_RANK_KERNELS_X86 && N >= 256 && N % 64 == 0 && sizeof(std::bitset<N>) == N/8;
+
+/** popcount(_b & _mask)
+ *
+ * Uses the load time selected kernel for large bitsets if the compiler does not
+ * target popcnt, otherwise std::bitset.
+ */
+template <size_t N>
+size_t andCount(std::bitset<N> const& _b, std::bitset<N> const& _mask) {
+#if FMC_RANK_KERNELS_DISPATCH_AND_COUNT
+    if constexpr (UsableFor<N>) {
+        if (activeAndCountKernel != Kernel::Scalar) {
+            return activeAndCount(reinterpret_cast<uint64_t const*>(&_b), reinterpret_cast<uint64_t const*>(&_mask), N/64);
+        }
+    }
+#endif
+    return (_b & _mask).count();
+}
+
+/** computes `_l | (_r & ~_bits)` and the number of its bits that are set in `_mask`
+ */
+template <size_t N>
+auto orAndNotCount(std::bitset<N> const& _l, std::bitset<N> const& _r, std::bitset<N> const& _bits, std::bitset<N> const& _mask) -> std::tuple<std::bitset<N>, size_t> {
+    if constexpr (UsableFor<N>) {
+#ifdef FMC_RANK_KERNELS_STATIC_OR_AND_NOT_COUNT
+        auto out = std::bitset<N>{};
+        auto count = FMC_RANK_KERNELS_STATIC_OR_AND_NOT_COUNT(reinterpret_cast<uint64_t const*>(&_l),
+                                                              reinterpret_cast<uint64_t const*>(&_r),
+                                                              reinterpret_cast<uint64_t const*>(&_bits),
+                                                              reinterpret_cast<uint64_t const*>(&_mask),
+                                                              reinterpret_cast<uint64_t*>(&out), N/64);
+        return {out, count};
+#else
+        if (activeOrAndNotCountKernel != Kernel::Scalar) {
+            auto out = std::bitset<N>{};
+            auto count = activeOrAndNotCount(reinterpret_cast<uint64_t const*>(&_l),
+                                             reinterpret_cast<uint64_t const*>(&_r),
+                                             reinterpret_cast<uint64_t const*>(&_bits),
+                                             reinterpret_cast<uint64_t const*>(&_mask),
+                                             reinterpret_cast<uint64_t*>(&out), N/64);
+            return {out, count};
+        }
+#endif
+    }
+    auto out = _l | (_r & ~_bits);
+    return {out, (out & _mask).count()};
+}
+
+}
@@ -5,68 +5,211 @@
 #include "../search_scheme/generator/h2.h"
 #include "../search_scheme/expand.h"
 
+#include <cstddef>
+#include <deque>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <tuple>
+#include <vector>
+
 namespace fmc {
 
+/** A bounded cache that is shared between threads
+ *
+ * Lookups take a shared lock, only inserting a new entry takes an exclusive lock.
+ * Values are created outside of any lock, if two threads create the same entry
+ * concurrently, the first one being inserted wins.
+ * If more than `capacity` entries are stored, the oldest entry is evicted. Entries
+ * are handed out as shared pointers, so evicted entries stay valid as long as they are used.
+ * A capacity of 0 disables caching, every call creates a new value.
+ */
+template <typename Key, typename Value>
+class SharedCache {
+    mutable std::shared_mutex                   mutex;
+    std::map<Key, std::shared_ptr<Value const>> entries;
+    std::deque<Key>                             insertionOrder;
+    size_t                                      capacity_;
+
+public:
+    explicit SharedCache(size_t _capacity)
+        : capacity_{_capacity}
+    {}
+
+    template <typename create_t>
+    auto get(Key const& _key, create_t const& _create) -> std::shared_ptr<Value const> {
+        {
+            auto lock = std::shared_lock{mutex};
+            if (auto iter = entries.find(_key); iter != entries.end()) {
+                return iter->second;
+            }
+        }
+        auto value = std::make_shared<Value const>(_create());
+
+        auto lock = std::unique_lock{mutex};
+        auto [iter, inserted] = entries.try_emplace(_key, std::move(value));
+        auto result = iter->second; // evict might erase this entry (e.g. capacity 0)
+        if (inserted) {
+            insertionOrder.push_back(_key);
+            evict();
+        }
+        return result;
+    }
+
+    size_t size() const {
+        auto lock = std::shared_lock{mutex};
+        return entries.size();
+    }
+
+    size_t capacity() const {
+        auto lock = std::shared_lock{mutex};
+        return capacity_;
+    }
+
+    void setCapacity(size_t _capacity) {
+        auto lock = std::unique_lock{mutex};
+        capacity_ = _capacity;
+        evict();
+    }
+
+    void clear() {
+        auto lock = std::unique_lock{mutex};
+        entries.clear();
+        insertionOrder.clear();
+    }
+
+private:
+    void evict() {
+        while (entries.size() > capacity_) {
+            entries.erase(insertionOrder.front());
+            insertionOrder.pop_front();
+        }
+    }
+};
+
+namespace detail {
+
+// default number of entries of each search scheme cache
+inline constexpr size_t searchSchemeCacheCapacity = 4096;
+
+using Scheme = fmc::search_scheme::Scheme;
+
+//!\brief cache of the generated h2 schemes, keyed by (parts, minError, maxError)
+inline auto h2Cache() -> SharedCache<std::tuple<size_t, size_t, size_t>, Scheme>& {
+    static auto cache = SharedCache<std::tuple<size_t, size_t, size_t>, Scheme>{searchSchemeCacheCapacity};
+    return cache;
+}
+
+//!\brief cache of the search schemes, keyed by (minError, maxError, shortLen)
+template <bool Edit>
+auto schemeCache() -> SharedCache<std::tuple<size_t, size_t, bool>, Scheme>& {
+    static auto cache = SharedCache<std::tuple<size_t, size_t, bool>, Scheme>{searchSchemeCacheCapacity};
+    return cache;
+}
+
+//!\brief cache of the search schemes expanded to a length, keyed by (length, minError, maxError)
+template <bool Edit>
+auto expandedSchemeCache() -> SharedCache<std::tuple<size_t, size_t, size_t>, Scheme>& {
+    static auto cache = SharedCache<std::tuple<size_t, size_t, size_t>, Scheme>{searchSchemeCacheCapacity};
+    return cache;
+}
+
+//!\brief cache of the uniform partitions, keyed by (parts, length)
+inline auto partitionCache() -> SharedCache<std::tuple<size_t, size_t>, std::vector<size_t>>& {
+    static auto cache = SharedCache<std::tuple<size_t, size_t>, std::vector<size_t>>{searchSchemeCacheCapacity};
+    return cache;
+}
+
+inline auto cachedH2(size_t _parts, size_t _minError, size_t _maxError) -> std::shared_ptr<Scheme const> {
+    return h2Cache().get({_parts, _minError, _maxError}, [&]() {
+        return fmc::search_scheme::generator::h2(_parts, _minError, _maxError);
+    });
+}
+
+/* Returns the entry of `_cache` for `_key`
+ *
+ * The last returned entry is memorized per thread (and per cache), so repeated
+ * requests for the same key don't touch the shared cache at all.
+ * The returned reference stays valid until the same thread requests a different key.
+ */
+template <typename Cache, typename Key, typename create_t>
+auto lookup(Cache& _cache, Key const& _key, create_t const& _create) -> auto const& {
+    static thread_local auto last = std::tuple<Key, std::shared_ptr<typename decltype(_cache.get(_key, _create))::element_type>>{};
+    auto& [lastKey, lastValue] = last;
+    if (!lastValue || lastKey != _key) {
+        lastValue = _cache.get(_key, _create);
+        lastKey   = _key;
+    }
+    return *lastValue;
+}
+
+}
+
 /** cache a search scheme (without expansion to length)
+ *
+ * The cache is shared between all threads, see SharedCache.
+ * The returned reference stays valid until the calling thread requests a different search scheme.
  *
  * @param _shortLen: indicates that the search scheme should work for short queries (length of 2)
  */
 template <bool Edit>
 auto getCachedSearchScheme(size_t _minError, size_t _maxError, bool _shortLen=false) -> auto const& {
-    static thread_local auto cache = std::tuple<size_t, size_t, bool, fmc::search_scheme::Scheme>{std::numeric_limits<size_t>::max(), 0, false, {}};
-    // check if last scheme has correct errors and length, otherwise generate it
-    auto& [minError, maxError, shortLen, search_scheme] = cache;
-    if (_minError != minError
-        || _maxError != maxError
-        || shortLen != _shortLen
-    ) { // regenerate everything
-        minError      = _minError;
-        maxError      = _maxError;
-        shortLen      = _shortLen;
-        search_scheme = fmc::search_scheme::generator::h2(maxError+(shortLen?1:2), minError, maxError);
-
+    return detail::lookup(detail::schemeCache<Edit>(), std::make_tuple(_minError, _maxError, _shortLen), [&]() {
+        auto search_scheme = *detail::cachedH2(_maxError+(_shortLen?1:2), _minError, _maxError);
         if constexpr (!Edit) {
             search_scheme = limitToHamming(search_scheme);
         }
-    }
-    return search_scheme;
+        return search_scheme;
+    });
 }
 
 /** cache a search scheme with expansion to length
+ *
+ * same as getCachedSearchScheme, but keyed by (Edit, length, minError, maxError)
  */
 template <bool Edit>
 auto getCachedSearchScheme(size_t _length, size_t _minError, size_t _maxError) -> auto const& {
-    static thread_local auto cache = std::tuple<size_t, size_t, size_t, fmc::search_scheme::Scheme, fmc::search_scheme::Scheme>{std::numeric_limits<size_t>::max(), 0, 0, {}, {}};
-    // check if last scheme has correct errors and length, other wise generate it
-    auto& [minError, maxError, length, ss, search_scheme] = cache;
-    if (_minError != minError || _maxError != maxError) { // regenerate everything
-        minError      = _minError;
-        maxError      = _maxError;
-        ss            = fmc::search_scheme::generator::h2(maxError+2, minError, maxError);
-        length        = _length;
-        search_scheme = fmc::search_scheme::expand(ss, length);
+    return detail::lookup(detail::expandedSchemeCache<Edit>(), std::make_tuple(_length, _minError, _maxError), [&]() {
+        auto search_scheme = fmc::search_scheme::expand(*detail::cachedH2(_maxError+2, _minError, _maxError), _length);
         if constexpr (!Edit) {
             search_scheme = limitToHamming(search_scheme);
         }
-    } else if (_length != length) {
-        length        = _length;
-        search_scheme = fmc::search_scheme::expand(ss, length);
-        if constexpr (!Edit) {
-            search_scheme = limitToHamming(search_scheme);
-        }
-    }
-    return search_scheme;
+        return search_scheme;
+    });
 }
 
 inline auto getCachedPartition(size_t _parts, size_t _length) -> auto const & {
-    static thread_local auto cache = std::tuple<size_t, size_t, std::vector<size_t>>{0, 0, {}};
-    auto& [length, parts, partition] = cache;
-    if (length != _length || parts != _parts) {
-        partition = fmc::search_scheme::createUniformPartition(_parts, _length);
-        parts = _parts;
-        length = _length;
+    return detail::lookup(detail::partitionCache(), std::make_tuple(_parts, _length), [&]() {
+        return fmc::search_scheme::createUniformPartition(_parts, _length);
+    });
+}
+
+/** Fills the search scheme caches for all query lengths in [_minLength, _maxLength]
+ *
+ * Meant to be called once at startup, so scheme generation does not show up while searching.
+ * Covers the unexpanded schemes + partitions (used by e.g. search_ng26) and the
+ * expanded schemes (used by e.g. search_ng24).
+ */
+template <bool Edit>
+void prewarmSearchSchemes(size_t _minLength, size_t _maxLength, size_t _minError, size_t _maxError) {
+    for (size_t length{_minLength}; length <= _maxLength; ++length) {
+        auto const& search_scheme = getCachedSearchScheme<Edit>(_minError, _maxError, /*.shortLen=*/(length==2));
+        getCachedPartition(search_scheme[0].pi.size(), length);
+        getCachedSearchScheme<Edit>(length, _minError, _maxError);
     }
-    return partition;
+}
+
+/** Sets the maximum number of entries of each search scheme cache
+ */
+inline void setSearchSchemeCacheCapacity(size_t _capacity) {
+    detail::h2Cache().setCapacity(_capacity);
+    detail::schemeCache<true>().setCapacity(_capacity);
+    detail::schemeCache<false>().setCapacity(_capacity);
+    detail::expandedSchemeCache<true>().setCapacity(_capacity);
+    detail::expandedSchemeCache<false>().setCapacity(_capacity);
+    detail::partitionCache().setCapacity(_capacity);
 }
 
 }
@@ -0,0 +1,147 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../concepts.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * Grouping of identical queries
+ *
+ * Batches of reads often contain exact duplicates (PCR/optical duplicates, amplicon panels).
+ * `groupQueries` hashes all queries and assigns identical ones to the same group, such that each
+ * group has to be searched only once (see fmc::search_deduplicated and
+ * search_no_errors::search_deduplicated). The first query of each group is its representative.
+ *
+ * Optionally, a query is also assigned to the group of its reverse complement. The hits of
+ * such a query are the hits of the reverse complement of the representative, which is only
+ * useful if the index contains both strands; it is marked via `reverseComplement`.
+ */
+namespace fmc {
+
+struct QueryGroups {
+    std::vector<size_t> representatives;   // qidx of the first query of each group
+    std::vector<size_t> groupOf;           // group of each query
+    std::vector<bool>   reverseComplement; // true if a query is the reverse complement of its representative
+    std::vector<size_t> memberOffsets{0};  // members of group g are members[memberOffsets[g], memberOffsets[g+1])
+    std::vector<size_t> members;
+
+    //!\brief number of groups
+    size_t size() const {
+        return representatives.size();
+    }
+
+    //!\brief all queries of group `_group` in increasing order, starting with its representative
+    auto membersOf(size_t _group) const -> std::span<size_t const> {
+        return std::span{members}.subspan(memberOffsets[_group], memberOffsets[_group+1] - memberOffsets[_group]);
+    }
+};
+
+namespace detail {
+
+template <std::ranges::range range_t>
+auto hashSequence(range_t&& _range) -> uint64_t {
+    // FNV-1a over all symbols
+    uint64_t hash{14695981039346656037ull};
+    for (auto v : _range) {
+        hash = (hash ^ static_cast<uint64_t>(v)) * 1099511628211ull;
+    }
+    return hash;
+}
+
+template <Sequences queries_t, typename complement_t>
+auto groupQueries(queries_t const& _queries, complement_t const* _complement) -> QueryGroups {
+    auto groups = QueryGroups{};
+    groups.groupOf.resize(_queries.size());
+    groups.reverseComplement.resize(_queries.size());
+
+    // hash of a sequence to groups with that hash
+    auto table = std::unordered_multimap<uint64_t, size_t>{};
+    table.reserve(_queries.size());
+
+    auto find = [&](uint64_t hash, auto const& query) -> std::optional<size_t> {
+        auto [first, last] = table.equal_range(hash);
+        for (auto iter = first; iter != last; ++iter) {
+            if (std::ranges::equal(_queries[groups.representatives[iter->second]], query)) {
+                return iter->second;
+            }
+        }
+        return std::nullopt;
+    };
+
+    for (size_t qidx{0}; qidx < _queries.size(); ++qidx) {
+        auto const& query = _queries[qidx];
+        auto hash  = hashSequence(query);
+        auto group = find(hash, query);
+        if (!group && _complement) {
+            auto rc = query | std::views::reverse | std::views::transform(*_complement);
+            if ((group = find(hashSequence(rc), rc))) {
+                groups.reverseComplement[qidx] = true;
+            }
+        }
+        if (!group) {
+            group = groups.representatives.size();
+            groups.representatives.push_back(qidx);
+            table.emplace(hash, *group);
+        }
+        groups.groupOf[qidx] = *group;
+    }
+
+    // members of each group, counting sort by group
+    groups.memberOffsets.assign(groups.size()+1, 0);
+    for (auto g : groups.groupOf) {
+        groups.memberOffsets[g+1] += 1;
+    }
+    for (size_t g{0}; g < groups.size(); ++g) {
+        groups.memberOffsets[g+1] += groups.memberOffsets[g];
+    }
+    groups.members.resize(_queries.size());
+    auto pos = std::vector<size_t>(groups.memberOffsets.begin(), groups.memberOffsets.end() - 1);
+    for (size_t qidx{0}; qidx < _queries.size(); ++qidx) {
+        groups.members[pos[groups.groupOf[qidx]]++] = qidx;
+    }
+    return groups;
+}
+
+}
+
+/** Groups identical queries
+ *
+ * \param _queries queries to group
+ */
+template <Sequences queries_t>
+auto groupQueries(queries_t const& _queries) -> QueryGroups {
+    using complement_t = uint8_t(*)(uint8_t);
+    return detail::groupQueries(_queries, static_cast<complement_t const*>(nullptr));
+}
+
+/** Groups queries that are identical or identical after reverse complementing
+ *
+ * \param _queries    queries to group
+ * \param _complement callback mapping a symbol to its complement, e.g. `[](uint8_t c) { return 5-c; }`
+ */
+template <Sequences queries_t, typename complement_t>
+auto groupQueries(queries_t const& _queries, complement_t const& _complement) -> QueryGroups {
+    return detail::groupQueries(_queries, &_complement);
+}
+
+/** View of the representative of each group
+ *
+ * The returned view references `_queries` and `_groups`.
+ */
+template <Sequences queries_t>
+auto representativeQueries(queries_t const& _queries, QueryGroups const& _groups) {
+    return _groups.representatives | std::views::transform([&_queries](size_t qidx) -> decltype(auto) {
+        return _queries[qidx];
+    });
+}
+
+}
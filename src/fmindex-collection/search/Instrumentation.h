@@ -0,0 +1,221 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../search_scheme/Scheme.h"
+#include "../search_scheme/weightedNodeCount.h"
+
+#include <cstddef>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/**
+ * Opt-in instrumentation of the search hot path
+ *
+ * Searches (search_ng26, search_ng28) and locate accept a policy object that is
+ * notified about every visited node, every cursor extension and every LF step.
+ * The default policy `Disabled` has empty inline hooks, so the instrumentation
+ * is compiled out completely. `Counters` collects per-query and aggregated counts.
+ *
+ * Usage:
+ *   auto stats = fmc::instrumentation::Counters{};
+ *   fmc::search_ng26::search<true>(index, queries, scheme, partition, delegate, stats);
+ *   std::cout << stats.toJson() << "\n";
+ */
+namespace fmc::instrumentation {
+
+//!\brief policy that records nothing, all hooks are optimized away
+struct Disabled {
+    static constexpr bool enabled = false;
+
+    void beginQuery(size_t /*_qidx*/, size_t /*_parts*/) {}
+    void node(size_t /*_part*/) {}
+    void extendAll() {}
+    void extendSymb() {}
+    void result(size_t /*_count*/) {}
+    void locateSteps(size_t /*_steps*/) {}
+};
+
+//!\brief counts of a single query (or of all queries)
+struct QueryCounters {
+    size_t              qidx{};
+    std::vector<size_t> nodes{};       // visited (non-empty) cursors, split by the part of the query that created them
+    size_t              extendAll{};   // cursor extensions computing the ranks of all symbols (e.g. extendLeft())
+    size_t              extendSymb{};  // cursor extensions computing the ranks of a single symbol (e.g. extendLeft(symb))
+                                       // (the number of bwt rank calls per extension depends on the index and cursor)
+    size_t              results{};     // number of reported rows
+    size_t              locateSteps{}; // LF steps taken while locating rows
+
+    size_t totalNodes() const {
+        return std::accumulate(nodes.begin(), nodes.end(), size_t{0});
+    }
+
+    //!\brief number of cursor extensions of both kinds
+    size_t extensions() const {
+        return extendAll + extendSymb;
+    }
+
+    void add(QueryCounters const& _other) {
+        if (nodes.size() < _other.nodes.size()) {
+            nodes.resize(_other.nodes.size(), 0);
+        }
+        for (size_t i{0}; i < _other.nodes.size(); ++i) {
+            nodes[i] += _other.nodes[i];
+        }
+        extendAll   += _other.extendAll;
+        extendSymb  += _other.extendSymb;
+        results     += _other.results;
+        locateSteps += _other.locateSteps;
+    }
+
+    auto toJson() const -> std::string {
+        auto r = std::string{"{"};
+        r += "\"qidx\": " + std::to_string(qidx);
+        r += ", \"nodes\": " + std::to_string(totalNodes());
+        r += ", \"nodes_per_part\": [";
+        for (size_t i{0}; i < nodes.size(); ++i) {
+            if (i > 0) r += ", ";
+            r += std::to_string(nodes[i]);
+        }
+        r += "]";
+        r += ", \"extensions\": " + std::to_string(extensions());
+        r += ", \"extend_all\": " + std::to_string(extendAll);
+        r += ", \"extend_symb\": " + std::to_string(extendSymb);
+        r += ", \"results\": " + std::to_string(results);
+        r += ", \"locate_steps\": " + std::to_string(locateSteps);
+        r += "}";
+        return r;
+    }
+};
+
+/**
+ * Policy that collects the counts of every query
+ *
+ * Not thread safe, use one object per thread and combine them via `merge`.
+ * Locate steps are attributed to the current query (the one of the last `beginQuery`
+ * call), or only to the aggregate if no query was started.
+ * With `recordQueries = false` only the aggregate is kept, memory does not grow with
+ * the number of queries, e.g. `auto stats = Counters{.recordQueries = false};`.
+ */
+struct Counters {
+    static constexpr bool enabled = true;
+
+    bool                       recordQueries{true}; // keep the counts of every single query in `queries`
+    std::vector<QueryCounters> queries{};           // one entry per searched query, in search order (if recordQueries)
+    QueryCounters              total{};             // sum over all queries
+    size_t                     queryCount{};        // number of searched queries
+    long double                predictedNodes{-1};  // nodes per query as predicted by weightedNodeCount, negative if unknown
+
+    void beginQuery(size_t _qidx, size_t _parts) {
+        queryCount += 1;
+        if (total.nodes.size() < _parts) {
+            total.nodes.resize(_parts, 0);
+        }
+        if (!recordQueries) return;
+        auto& q = queries.emplace_back();
+        q.qidx  = _qidx;
+        q.nodes.resize(_parts, 0);
+    }
+    void node(size_t _part) {
+        if (queryCount == 0) return;
+        if (_part >= total.nodes.size()) total.nodes.resize(_part+1, 0);
+        total.nodes[_part] += 1;
+        if (auto q = current()) {
+            if (_part >= q->nodes.size()) q->nodes.resize(_part+1, 0);
+            q->nodes[_part] += 1;
+        }
+    }
+    void extendAll() {
+        if (auto q = current()) q->extendAll += 1;
+        total.extendAll += 1;
+    }
+    void extendSymb() {
+        if (auto q = current()) q->extendSymb += 1;
+        total.extendSymb += 1;
+    }
+    void result(size_t _count) {
+        if (auto q = current()) q->results += _count;
+        total.results += _count;
+    }
+    void locateSteps(size_t _steps) {
+        if (auto q = current()) q->locateSteps += _steps;
+        total.locateSteps += _steps;
+    }
+
+    //!\brief appends the counts of `_other`, e.g. collected by a different thread
+    void merge(Counters const& _other) {
+        if (recordQueries) {
+            queries.insert(queries.end(), _other.queries.begin(), _other.queries.end());
+        }
+        total.add(_other.total);
+        queryCount += _other.queryCount;
+    }
+
+    void clear() {
+        *this = Counters{.recordQueries = recordQueries};
+    }
+
+    //!\brief average number of visited nodes per query
+    double nodesPerQuery() const {
+        if (queryCount == 0) return 0.;
+        return double(total.totalNodes()) / queryCount;
+    }
+
+    /**
+     * Stores the number of nodes per query as predicted by weightedNodeCount
+     *
+     * \param _expanded search scheme expanded to the query length
+     * \param _sigma    size of the alphabet (without delimiter)
+     * \param _N        size of the reference text
+     */
+    template <bool Edit>
+    void predict(search_scheme::Scheme const& _expanded, size_t _sigma, size_t _N) {
+        predictedNodes = search_scheme::weightedNodeCount<Edit>(_expanded, _sigma, _N);
+    }
+
+    /**
+     * Exports all counters as a json object
+     *
+     * \param _perQuery include the counts of every single query
+     */
+    auto toJson(bool _perQuery = true) const -> std::string {
+        auto r = std::string{"{"};
+        r += "\"queries\": " + std::to_string(queryCount);
+        r += ", \"total\": " + total.toJson();
+        r += ", \"nodes_per_query\": " + std::to_string(nodesPerQuery());
+        if (predictedNodes >= 0) {
+            r += ", \"predicted_nodes_per_query\": " + std::to_string(double(predictedNodes));
+        }
+        if (_perQuery && recordQueries) {
+            r += ", \"per_query\": [";
+            for (size_t i{0}; i < queries.size(); ++i) {
+                if (i > 0) r += ", ";
+                r += queries[i].toJson();
+            }
+            r += "]";
+        }
+        r += "}";
+        return r;
+    }
+
+private:
+    //!\brief counts of the current query, nullptr if queries are not recorded
+    auto current() -> QueryCounters* {
+        if (!recordQueries || queries.empty()) return nullptr;
+        return &queries.back();
+    }
+};
+
+template <typename T>
+concept Policy = requires(T& t) {
+    { T::enabled };
+    t.beginQuery(size_t{}, size_t{});
+    t.node(size_t{});
+    t.extendAll();
+    t.extendSymb();
+    t.result(size_t{});
+    t.locateSteps(size_t{});
+};
+
+}
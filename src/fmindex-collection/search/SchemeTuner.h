@@ -0,0 +1,262 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../search_scheme/expand.h"
+#include "../search_scheme/generator/all.h"
+#include "../search_scheme/isComplete.h"
+#include "SelectCursor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+/**
+ * Index-aware search scheme tuner
+ *
+ * weightedNodeCount (and expandByWNC/optimizeByWNC) estimates the number of visited
+ * nodes assuming a uniform random text. This tuner measures the nodes instead:
+ * it samples queries from the text of the actual index (so they follow its real
+ * symbol distribution and repeat structure), counts the nodes a search visits
+ * on the index and picks the generator and part sizes with the fewest nodes.
+ */
+namespace fmc::scheme_tuner {
+
+struct Config {
+    size_t                   sampleCount{64}; // number of sampled queries
+    size_t                   seed{0};         // seed for sampling queries and errors
+    size_t                   maxRounds{64};   // maximum number of improvement steps of the part sizes
+    std::vector<std::string> generators{"h2-k1", "h2-k2", "h2-k3", "kianfar", "kucherov-k1", "kucherov-k2", "optimum", "pigeon_opt", "01*0_opt"};
+};
+
+struct Result {
+    std::string                 generator;    // name as in search_scheme::generator::all
+    search_scheme::Scheme       scheme;       // unexpanded scheme, e.g. for search_ng26
+    std::vector<size_t>         partition;    // size of each part, e.g. for search_ng26
+    search_scheme::Scheme       expanded;     // scheme expanded to the query length, e.g. for search_pseudo
+    double                      nodes{};      // average number of visited nodes per query
+    std::vector<double>         nodesPerPart; // average number of visited nodes per query, split by part
+};
+
+/* Counts the nodes a search scheme visits on an index
+ *
+ * Traverses the search tree like search_pseudo, each non-empty cursor is one node.
+ * Nodes are attributed to the part of the query position that created them.
+ */
+template <bool Edit, typename index_t, typename query_t>
+struct NodeCounter {
+    using cursor_t = select_cursor_t<index_t>;
+    constexpr static size_t Sigma     = index_t::Sigma;
+    constexpr static size_t FirstSymb = []() -> size_t {
+        if constexpr (requires() { { index_t::FirstSymb }; }) {
+            return index_t::FirstSymb;
+        }
+        return 1;
+    }();
+
+    index_t const&              index;
+    query_t const&              query;
+    search_scheme::Search const& search;
+    std::vector<size_t> const&  partOfQueryPos;
+    std::vector<size_t>&        nodes;
+
+    void run() {
+        count(cursor_t{index}, 0, 0);
+    }
+
+    auto extend(cursor_t const& cur, size_t pos) const {
+        if (pos == 0 or search.pi[pos-1] < search.pi[pos]) {
+            return cur.extendRight();
+        } else {
+            return cur.extendLeft();
+        }
+    }
+
+    void count(cursor_t const& cur, size_t e, size_t pos) const {
+        if (cur.count() == 0) return;
+        if (pos > 0) {
+            nodes[partOfQueryPos[search.pi[pos-1]]] += 1;
+        }
+        if (pos == query.size()) return;
+        if (e > search.u[pos]) return;
+
+        auto symb    = query[search.pi[pos]];
+        auto cursors = extend(cur, pos);
+
+        if (search.l[pos] <= e) {
+            count(cursors[symb], e, pos+1);
+        }
+        if (search.l[pos] <= e+1 and e+1 <= search.u[pos]) {
+            for (size_t i{FirstSymb}; i < Sigma; ++i) {
+                if (i == symb) continue;
+                count(cursors[i], e+1, pos+1);
+            }
+            if constexpr (Edit) {
+                count(cur, e+1, pos+1); // insertion
+            }
+        }
+        if constexpr (Edit) {
+            if (e+1 <= search.u[pos]) {
+                for (size_t i{FirstSymb}; i < Sigma; ++i) {
+                    count(cursors[i], e+1, pos); // deletion
+                }
+            }
+        }
+    }
+};
+
+/**
+ * Samples `_count` substrings of length `_length` from the text of the index
+ *
+ * Substrings are read by walking LF from random rows, substrings that would
+ * cross a sequence boundary are discarded. Each sample gets a uniformly chosen
+ * number of random substitutions in [0, _maxErrors].
+ */
+template <typename index_t>
+auto sampleQueries(index_t const& _index, size_t _length, size_t _count, size_t _maxErrors, size_t _seed) -> std::vector<std::vector<uint8_t>> {
+    constexpr size_t FirstSymb = NodeCounter<false, index_t, std::vector<uint8_t>>::FirstSymb;
+    auto rng     = std::mt19937_64{_seed};
+    auto queries = std::vector<std::vector<uint8_t>>{};
+    for (size_t attempts{0}; queries.size() < _count && attempts < _count * 100; ++attempts) {
+        auto query = std::vector<uint8_t>{};
+        size_t idx = rng() % _index.size();
+        while (query.size() < _length) {
+            auto symb = _index.bwt.symbol(idx);
+            if (symb < FirstSymb) break;
+            query.push_back(symb);
+            idx = _index.bwt.rank(idx, symb) + _index.C[symb];
+        }
+        if (query.size() < _length) continue;
+        std::ranges::reverse(query);
+        for (size_t i{0}, n = rng() % (_maxErrors+1); i < n; ++i) {
+            query[rng() % _length] = FirstSymb + rng() % (index_t::Sigma - FirstSymb);
+        }
+        queries.push_back(std::move(query));
+    }
+    if (queries.empty()) {
+        throw std::runtime_error{"no sequence of the index is long enough to sample queries of length " + std::to_string(_length)};
+    }
+    return queries;
+}
+
+/**
+ * Counts the visited nodes of a scheme with the given part sizes, summed over all queries
+ *
+ * \return total number of nodes, split by part
+ */
+template <bool Edit, typename index_t>
+auto countNodes(index_t const& _index, std::vector<std::vector<uint8_t>> const& _queries, search_scheme::Scheme const& _expanded, std::vector<size_t> const& _partition) -> std::vector<size_t> {
+    auto partOfQueryPos = std::vector<size_t>{};
+    for (size_t part{0}; part < _partition.size(); ++part) {
+        partOfQueryPos.insert(partOfQueryPos.end(), _partition[part], part);
+    }
+    auto nodes = std::vector<size_t>(_partition.size(), 0);
+    for (auto const& query : _queries) {
+        for (auto const& search : _expanded) {
+            NodeCounter<Edit, index_t, std::vector<uint8_t>>{_index, query, search, partOfQueryPos, nodes}.run();
+        }
+    }
+    return nodes;
+}
+
+/**
+ * Picks the search scheme generator and part sizes with the fewest visited nodes on `_index`
+ *
+ * For every generator the part sizes start uniform and are improved greedily by moving
+ * single positions between parts, as long as the number of nodes decreases.
+ *
+ * \param _length   length of the queries
+ * \param _minError minimal number of errors
+ * \param _maxError maximal number of errors
+ */
+template <bool Edit, typename index_t>
+auto tune(index_t const& _index, size_t _length, size_t _minError, size_t _maxError, Config const& _config = {}) -> Result {
+    auto queries = sampleQueries(_index, _length, _config.sampleCount, _maxError, _config.seed);
+
+    auto expandWith = [&](search_scheme::Scheme const& ss, std::vector<size_t> const& partition) {
+        auto expanded = search_scheme::expand(ss, partition);
+        if constexpr (!Edit) {
+            expanded = search_scheme::limitToHamming(expanded);
+        }
+        return expanded;
+    };
+
+    auto best = std::optional<Result>{};
+    for (auto const& name : _config.generators) {
+        auto iter = search_scheme::generator::all.find(name);
+        if (iter == search_scheme::generator::all.end()) {
+            throw std::runtime_error{"unknown search scheme generator \"" + name + "\""};
+        }
+
+        // not every generator supports every error configuration
+        auto ss = search_scheme::Scheme{};
+        try {
+            ss = iter->second.generator(_minError, _maxError, index_t::Sigma, _index.size());
+        } catch (...) {
+            continue;
+        }
+        if (ss.empty() || ss[0].pi.size() > _length || !search_scheme::isComplete(ss, _minError, _maxError)) continue;
+
+        auto partition = search_scheme::expandCount(ss[0].pi.size(), _length);
+        auto evaluate  = [&](std::vector<size_t> const& p) -> size_t {
+            auto expanded = expandWith(ss, p);
+            if (expanded.size() != ss.size()) return std::numeric_limits<size_t>::max(); // some searches became invalid
+            auto nodes = countNodes<Edit>(_index, queries, expanded, p);
+            return std::accumulate(nodes.begin(), nodes.end(), size_t{0});
+        };
+        auto nodes = evaluate(partition);
+
+        // greedily move one position from one part to another
+        for (size_t round{0}; round < _config.maxRounds; ++round) {
+            auto bestMove = std::optional<std::tuple<size_t, size_t, size_t>>{};
+            for (size_t i1{0}; i1 < partition.size(); ++i1) {
+                if (partition[i1] <= 1) continue;
+                for (size_t i2{0}; i2 < partition.size(); ++i2) {
+                    if (i1 == i2) continue;
+                    partition[i1] -= 1;
+                    partition[i2] += 1;
+                    auto n = evaluate(partition);
+                    partition[i1] += 1;
+                    partition[i2] -= 1;
+                    if (n < nodes && (!bestMove || n < std::get<2>(*bestMove))) {
+                        bestMove = {i1, i2, n};
+                    }
+                }
+            }
+            if (!bestMove) break;
+            auto [i1, i2, n] = *bestMove;
+            partition[i1] -= 1;
+            partition[i2] += 1;
+            nodes = n;
+        }
+
+        if (best && best->nodes <= double(nodes) / queries.size()) continue;
+        auto expanded     = expandWith(ss, partition);
+        auto perPart      = countNodes<Edit>(_index, queries, expanded, partition);
+        auto nodesPerPart = std::vector<double>{};
+        for (auto n : perPart) {
+            nodesPerPart.push_back(double(n) / queries.size());
+        }
+        best = Result {
+            .generator    = name,
+            .scheme       = ss,
+            .partition    = partition,
+            .expanded     = std::move(expanded),
+            .nodes        = double(nodes) / queries.size(),
+            .nodesPerPart = std::move(nodesPerPart),
+        };
+    }
+    if (!best) {
+        throw std::runtime_error{"no search scheme generator supports the requested errors and length"};
+    }
+    return *best;
+}
+
+}
@@ -0,0 +1,187 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../locate.h"
+#include "../verify.h"
+#include "SearchNg26.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <optional>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+/**
+ * search_ng26 with a verification policy:
+ *  - switches to in-text verification as soon as the interval has less than `threshold` entries
+ *  - reports text positions (seqId, pos, errors) instead of cursors
+ *  - requires the sampled inverse suffix array of the index (`index.isa`) to access the text
+ *
+ * Result contract: each text position is reported at most once, with the lowest number of
+ * errors found for it. For hamming distance the results are identical to search_ng26 + locate.
+ * For edit distance a verified occurrence is reported only with the start position of its best
+ * left alignment (fewest errors, then closest to the query length), while search_ng26 reports
+ * every start position with an alignment. Start positions of both might differ by up to
+ * `maxErrors`. A threshold of 0 disables verification and gives the results of search_ng26 + locate.
+ */
+namespace fmc::search_hybrid {
+
+namespace detail {
+
+/* Aligns the complete query against a prefix of `_text`
+ *
+ * Edit distance: semi global alignment, the end inside `_text` is free (bit-parallel, see MyersVerifier).
+ * Hamming distance: compares the query against the first `query.size()` symbols of `_text`.
+ * \return (errors, length of the aligned text prefix) of the best alignment, or std::nullopt if more than `_maxErrors` are required
+ */
+template <bool Edit>
+auto alignPrefix(MyersVerifier const& _verifier, std::vector<uint8_t> const& _text, size_t _maxErrors) -> std::optional<std::tuple<size_t, size_t>> {
+    if constexpr (!Edit) {
+        auto const& query = _verifier.query;
+        if (_text.size() < query.size()) return std::nullopt;
+        size_t e{0};
+        for (size_t i{0}; i < query.size() && e <= _maxErrors; ++i) {
+            e += (query[i] != _text[i]);
+        }
+        if (e > _maxErrors) return std::nullopt;
+        return std::make_tuple(e, query.size());
+    } else {
+        auto best = _verifier.findBest(_text, _maxErrors, /*._anchored=*/true);
+        if (!best) return std::nullopt;
+        auto [end, errors] = *best;
+        return std::make_tuple(errors, end);
+    }
+}
+
+}
+
+/* Verification policy for search_ng26::Search
+ *
+ * Intervals with less than `threshold` entries are located and the unmatched parts
+ * of the query are aligned directly against the text left and right of each occurrence.
+ */
+template <bool Edit, typename index_t, typename query_t, typename delegate_t>
+struct Verification {
+    index_t const& index;
+    query_t const& query;
+    size_t maxErrors;
+    size_t threshold;
+    delegate_t const& delegate;
+
+    template <typename cursor_t>
+    bool switchToVerification(cursor_t const& _cur) const {
+        return _cur.count() < threshold;
+    }
+
+    /* Verifies the unmatched parts of the query directly against the text
+     *
+     * The cursor matches `query[_queryBegin, _queryEnd)` with `_e` errors. For every
+     * occurrence the text left and right of it is extracted and the remaining query
+     * prefix and suffix are aligned with the remaining errors.
+     */
+    template <typename cursor_t>
+    bool verify(cursor_t const& _cur, size_t _queryBegin, size_t _queryEnd, size_t _e) const {
+        if (_e > maxErrors) return false;
+        auto const remaining = maxErrors - _e;
+
+        // left side is aligned backwards, starting at the occurrence
+        auto leftQuery  = std::vector<uint8_t>(query.begin(), query.begin() + _queryBegin);
+        auto rightQuery = std::vector<uint8_t>(query.begin() + _queryEnd, query.end());
+        std::ranges::reverse(leftQuery);
+        auto leftVerifier  = MyersVerifier{leftQuery};
+        auto rightVerifier = MyersVerifier{rightQuery};
+
+        for (auto [seqId, pos, offset] : LocateLinear{index, _cur}) {
+            auto start  = pos + offset;
+            auto end    = start + _cur.steps;
+            auto seqLen = index.isa.length(seqId);
+
+            auto leftLen  = std::min(start, leftQuery.size() + remaining);
+            auto leftText = index.extract(seqId, start - leftLen, start);
+            std::ranges::reverse(leftText);
+            auto left = detail::alignPrefix<Edit>(leftVerifier, leftText, remaining);
+            if (!left) continue;
+            auto [leftErrors, leftTextLen] = *left;
+
+            auto rightLen  = std::min(seqLen - end, rightQuery.size() + remaining - leftErrors);
+            auto rightText = index.extract(seqId, end, end + rightLen);
+            auto right = detail::alignPrefix<Edit>(rightVerifier, rightText, remaining - leftErrors);
+            if (!right) continue;
+            auto [rightErrors, rightTextLen] = *right;
+
+            delegate(seqId, start - leftTextLen, _e + leftErrors + rightErrors);
+        }
+        return false;
+    }
+};
+
+/* searches a single query, results are reported once per text position with their lowest number of errors
+ *
+ * See the result contract at the top of this file.
+ *
+ * \param threshold: intervals with less than `threshold` entries are verified inside the text, 0 disables verification
+ * \param delegate:  callback function to report the results, must accept (size_t seqId, size_t pos, size_t e)
+ */
+template <bool Edit, typename index_t, Sequence query_t, typename delegate_t>
+void search_impl(index_t const& index, query_t const& query, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, size_t threshold, delegate_t&& delegate) {
+    if (threshold > 0 && index.isa.size() == 0) {
+        throw std::runtime_error{"hybrid search requires the sampled inverse suffix array of the index (index.isa)"};
+    }
+
+    auto hits = std::vector<std::tuple<size_t, size_t, size_t>>{};
+    auto collect = [&](size_t seqId, size_t pos, size_t e) {
+        hits.emplace_back(seqId, pos, e);
+    };
+    // intervals that are searched to the end are located
+    auto report = [&](auto cur, size_t e) {
+        for (auto [seqId, pos, offset] : LocateLinear{index, cur}) {
+            collect(seqId, pos + offset, e);
+        }
+        return false;
+    };
+    auto stats = instrumentation::Disabled{};
+    for (auto const& search : search_scheme) {
+        using verification_t = Verification<Edit, index_t, query_t, decltype(collect)>;
+        auto verification = verification_t{index, query, search.u.back(), threshold, collect};
+        search_ng26::Search<Edit, index_t, query_t, decltype(search), decltype(report), decltype(stats), verification_t>{index, query, search, partition, report, stats, verification}.run();
+    }
+
+    // the same position might be reached by multiple searches and by different alignments
+    std::ranges::sort(hits);
+    for (size_t i{0}; i < hits.size(); ++i) {
+        auto [seqId, pos, e] = hits[i];
+        if (i > 0 && std::get<0>(hits[i-1]) == seqId && std::get<1>(hits[i-1]) == pos) continue;
+        delegate(seqId, pos, e);
+    }
+}
+
+// convenience function, with passed search scheme and multiple queries
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
+void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, size_t threshold, delegate_t&& delegate) {
+    for (size_t qidx{}; qidx < queries.size(); ++qidx) {
+        search_impl<Edit>(index, queries[qidx], search_scheme, partition, threshold, [&](size_t seqId, size_t pos, size_t e) {
+            delegate(qidx, seqId, pos, e);
+        });
+    }
+}
+
+/* convenience function, with auto selected search scheme and multiple queries
+ *
+ * \param threshold: intervals with less than `threshold` entries are verified inside the text
+ * \param delegate:  callback function to report the results, must accept (size_t qidx, size_t seqId, size_t pos, size_t e)
+ */
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
+void search(index_t const& index, queries_t&& queries, size_t maxErrors, size_t threshold, delegate_t&& delegate) {
+    for (size_t qidx{}; qidx < queries.size(); ++qidx) {
+        auto length = queries[qidx].size();
+        auto const& search_scheme = getCachedSearchScheme<Edit>(0, maxErrors, /*.shortLen=*/(length==2));
+        auto const& partition     = getCachedPartition(search_scheme[0].pi.size(), length);
+        search_impl<Edit>(index, queries[qidx], search_scheme, partition, threshold, [&](size_t seqId, size_t pos, size_t e) {
+            delegate(qidx, seqId, pos, e);
+        });
+    }
+}
+
+}
@@ -3,11 +3,14 @@
 #pragma once
 
 #include "CachedSearchScheme.h"
+#include "Instrumentation.h"
 #include "Restore.h"
 #include "SelectCursor.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <optional>
 
 /**
  * like search_ng25 but:
@@ -15,7 +18,18 @@
  */
 namespace fmc::search_ng26 {
 
-template <bool Edit, typename index_t, typename query_t, typename search_t, typename delegate_t>
+/* Default verification policy of Search, the search never leaves the index
+ *
+ * A verification policy provides two functions:
+ *  - `bool switchToVerification(cursor_t const& cur)`: asked before each extension, if it returns true
+ *    the remaining query is not searched inside the index anymore
+ *  - `bool verify(cursor_t const& cur, size_t queryBegin, size_t queryEnd, size_t e)`: finishes the search,
+ *    `cur` matches `query[queryBegin, queryEnd)` with `e` errors. The return value has the same meaning
+ *    as the return value of the delegate (true stops the search)
+ */
+struct NoVerification {};
+
+template <bool Edit, typename index_t, typename query_t, typename search_t, typename delegate_t, typename stats_t = instrumentation::Disabled, typename verification_t = NoVerification>
 struct Search {
     constexpr static size_t Sigma = index_t::Sigma;
     constexpr static size_t FirstSymb = []() -> size_t {
@@ -32,6 +46,8 @@ struct Search {
     search_t const& search;
     std::vector<size_t> const& partition;
     delegate_t const& delegate;
+    stats_t& stats;
+    [[no_unique_address]] verification_t verification;
 
     struct Side {
         uint8_t lastRank{};
@@ -51,12 +67,14 @@ struct Search {
         bool NextPos{};
     };
 
-    Search(index_t const& _index, query_t const& _query, search_t const& _search, std::vector<size_t> const& _partition, delegate_t const& _delegate)
-        : index     {_index}
-        , query     {_query}
-        , search    {_search}
-        , partition {_partition}
-        , delegate  {_delegate}
+    Search(index_t const& _index, query_t const& _query, search_t const& _search, std::vector<size_t> const& _partition, delegate_t const& _delegate, stats_t& _stats, verification_t _verification = {})
+        : index        {_index}
+        , query        {_query}
+        , search       {_search}
+        , partition    {_partition}
+        , delegate     {_delegate}
+        , stats        {_stats}
+        , verification {_verification}
     {}
 
     bool run() {
@@ -75,11 +93,73 @@ struct Search {
         state.LInfo = 'M';
         state.RInfo = 'M';
 
+        if constexpr (requires() { { index.kmerLookup.k }; }) {
+            lookupKMer(state);
+        }
+
         return search_next(state);
     }
 
+    /* Skips the first k steps via the k-mer lookup table of the index
+     *
+     * Only possible if the search starts with at least k symbols
+     * that are extended to the right without allowing any errors.
+     * The k skipped nodes are reported to `stats` as if they had been visited,
+     * unless the k-mer does not occur, which ends the search right away.
+     */
+    void lookupKMer(State& state) const {
+        auto const k = index.kmerLookup.k;
+        if (k == 0) return;
+
+        size_t errorFreeLen{0};
+        for (size_t j{0}; j < search.pi.size() && search.u[j] == 0 && search.pi[j] == search.pi[0] + j; ++j) {
+            errorFreeLen += partition[search.pi[j]];
+        }
+        if (errorFreeLen < k) return;
+
+        auto entry = index.kmerLookup.find(query, state.queryPosR);
+        if (!entry) return;
+        auto [lb, lbRev, len] = *entry;
+        state.cur = cursor_t{index, lb, lbRev, len, k};
+
+        // advance through the parts, as if the k symbols had been matched one by one
+        for (size_t remaining{k}; remaining > 0;) {
+            auto steps = std::min(remaining, state.partitionEntryValue);
+            if (len > 0) {
+                for (size_t i{0}; i < steps; ++i) {
+                    stats.node(search.pi[state.part]);
+                }
+            }
+            state.partitionEntryValue -= steps;
+            state.queryPosR           += steps;
+            remaining                 -= steps;
+            if (state.partitionEntryValue == 0) {
+                state.part += 1;
+                if (state.part != partition.size()) {
+                    state.partitionEntryValue = partition[search.pi[state.part]];
+                }
+            }
+        }
+        state.side[true].lastRank  = query[state.queryPosR-1];
+        state.side[true].lastQRank = query[state.queryPosR-1];
+    }
+
+
+    /* Asks the verification policy if the search of `state` should be finished outside of the index
+     *
+     * \return std::nullopt if the search continues inside the index, otherwise the result of the verification
+     */
+    auto switchToVerification(State const& state) const -> std::optional<bool> {
+        if constexpr (!std::same_as<verification_t, NoVerification>) {
+            if (verification.switchToVerification(state.cur)) {
+                return verification.verify(state.cur, state.queryPosL + 1, state.queryPosR, state.e);
+            }
+        }
+        return std::nullopt;
+    }
 
     auto extend(State const& state, uint64_t symb) const noexcept {
+        stats.extendSymb();
         if (state.Right) {
             return state.cur.extendRight(symb);
         } else {
@@ -87,6 +167,7 @@ struct Search {
         }
     }
     auto extend(State const& state) const noexcept {
+        stats.extendAll();
         if (state.Right) {
             return state.cur.extendRight();
         } else {
@@ -106,6 +187,9 @@ struct Search {
             }
             return false;
         }
+        if (auto res = switchToVerification(state)) {
+            return *res;
+        }
 
         auto newState = state;
         newState.Right = (state.part==0) || (search.pi[state.part-1] < search.pi[state.part]);
@@ -118,6 +202,7 @@ struct Search {
 
     bool search_next_pos(State state) const {
         if (state.cur.count() == 0) return false;
+        stats.node(search.pi[state.part]);
         if (state.NextPos) {
             if (state.Right) state.queryPosR += 1;
             else state.queryPosL -= 1;
@@ -132,6 +217,9 @@ struct Search {
                 return res;
             }
         }
+        if (auto res = switchToVerification(state)) {
+            return *res;
+        }
 
         if (state.cur.count() > 1) {
             return search_next_dir(state);
@@ -229,6 +317,7 @@ struct Search {
             nextSymb = query[state.Right?(state.queryPosR+i):(state.queryPosL-i)];
             state.cur = extend(state, nextSymb);
             if (state.cur.count() == 0) return false;
+            stats.node(search.pi[state.part]);
         }
 
         state.side[state.Right].lastRank = nextSymb;
@@ -264,6 +353,7 @@ struct Search {
         char const OnInsertionR  = state.Right ? 'I'   : state.RInfo;
 
 
+        stats.extendSymb();
         auto [curISymb, icursorNext] = [&]() -> std::tuple<size_t, cursor_t> {
             if (state.Right) {
                 auto symb = state.cur.symbolRight();
@@ -366,8 +456,8 @@ struct Search {
 };
 
 
-template <bool Edit, typename index_t, Sequence query_t, typename delegate_t>
-void search_impl(index_t const& index, query_t const& query, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate) {
+template <bool Edit, typename index_t, Sequence query_t, typename delegate_t, typename stats_t = instrumentation::Disabled>
+void search_impl(index_t const& index, query_t const& query, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, stats_t&& stats = {}) {
     using cursor_t = select_cursor_t<index_t>;
     using R = std::decay_t<decltype(delegate(std::declval<cursor_t>(), 0))>;
 
@@ -383,7 +473,7 @@ void search_impl(index_t const& index, query_t const& query, search_scheme::Sche
     }();
 
     for (auto const& search : search_scheme) {
-        bool f = Search<Edit, index_t, query_t, decltype(search), decltype(internal_delegate)>{index, query, search, partition, internal_delegate}.run();
+        bool f = Search<Edit, index_t, query_t, decltype(search), decltype(internal_delegate), std::remove_cvref_t<stats_t>>{index, query, search, partition, internal_delegate, stats}.run();
         if (f) {
             return;
         }
@@ -403,44 +493,61 @@ void search_impl(index_t const& index, query_t const& query, search_scheme::Sche
  *          e:    number of errors that these matches have
  * \param searchSelectSearchScheme_t: callback that helps selecting a proper search scheme, Must accept one parameters: size_t length
  *          length: length of query
+ * \param stats: instrumentation policy, see instrumentation::Counters
  */
-template <bool Edit, typename index_t, Sequences queries_t, typename selectSearchScheme_t, typename delegate_t>
-void search_n_impl(index_t const& index, queries_t&& queries, selectSearchScheme_t&& selectSearchScheme, delegate_t&& delegate, size_t n) {
+template <bool Edit, typename index_t, Sequences queries_t, typename selectSearchScheme_t, typename delegate_t, typename stats_t>
+void search_n_impl(index_t const& index, queries_t&& queries, selectSearchScheme_t&& selectSearchScheme, delegate_t&& delegate, size_t n, stats_t& stats) {
     if (queries.empty()) return;
     if (n == 0) return;
     for (size_t qidx{}; qidx < queries.size(); ++qidx) {
         size_t ct{};
         auto const& [search_scheme, partition] = selectSearchScheme(queries[qidx].size());
+        stats.beginQuery(qidx, partition.size());
         search_impl<Edit>(index, queries[qidx], search_scheme, partition, [&] (auto cur, size_t e) {
             if (cur.count() + ct > n) {
                 cur.len = n-ct;
             }
             ct += cur.count();
+            stats.result(cur.count());
             delegate(qidx, cur, e);
             return ct == n;
-        });
+        }, stats);
     }
 }
 
-// convenience function, with passed search scheme and multiple queries
-template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
-void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+// convenience function, with passed search scheme, multiple queries and instrumentation
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t, instrumentation::Policy stats_t>
+void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, stats_t& stats, size_t n = std::numeric_limits<size_t>::max()) {
     // function that selects a search scheme
     auto selectSearchScheme = [&]([[maybe_unused]] size_t length) -> auto {
         return std::tie(search_scheme, partition);
     };
-    search_n_impl<Edit>(index, queries, selectSearchScheme, delegate, n);
+    search_n_impl<Edit>(index, queries, selectSearchScheme, delegate, n, stats);
 }
 
-// convenience function, with auto selected search scheme and multiple queries
+// convenience function, with passed search scheme and multiple queries
 template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
-void search(index_t const& index, queries_t&& queries, size_t maxErrors, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+    auto stats = instrumentation::Disabled{};
+    search<Edit>(index, queries, search_scheme, partition, delegate, stats, n);
+}
+
+// convenience function, with auto selected search scheme, multiple queries and instrumentation
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t, instrumentation::Policy stats_t>
+void search(index_t const& index, queries_t&& queries, size_t maxErrors, delegate_t&& delegate, stats_t& stats, size_t n = std::numeric_limits<size_t>::max()) {
     auto selectSearchScheme = [&]([[maybe_unused]] size_t length) -> auto {
         auto const& search_scheme = getCachedSearchScheme<Edit>(0, maxErrors, /*.shortLen=*/(length==2));
         auto const& partition     = getCachedPartition(search_scheme[0].pi.size(), length);
         return std::tie(search_scheme, partition);
     };
-    search_n_impl<Edit>(index, queries, selectSearchScheme, delegate, n);
+    search_n_impl<Edit>(index, queries, selectSearchScheme, delegate, n, stats);
+}
+
+// convenience function, with auto selected search scheme and multiple queries
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
+void search(index_t const& index, queries_t&& queries, size_t maxErrors, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+    auto stats = instrumentation::Disabled{};
+    search<Edit>(index, queries, maxErrors, delegate, stats, n);
 }
 
 
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "CachedSearchScheme.h"
+#include "Instrumentation.h"
 #include "Restore.h"
 #include "SelectCursor.h"
 
@@ -16,7 +17,7 @@
  */
 namespace fmc::search_ng28 {
 
-template <bool Edit, typename index_t, typename query_t, typename search_t, typename delegate_t>
+template <bool Edit, typename index_t, typename query_t, typename search_t, typename delegate_t, typename stats_t = instrumentation::Disabled>
 struct Search {
     using cursor_t = select_cursor_t<index_t>;
 
@@ -33,6 +34,7 @@ struct Search {
     search_t const& search;
     std::vector<size_t> partition;
     delegate_t const& delegate;
+    stats_t& stats;
 
     enum dir_t : int {
         Left = -1,
@@ -53,12 +55,13 @@ struct Search {
     mutable size_t partitionPart{};
     mutable uint8_t lb, ub;
 
-    Search(index_t const& _index, query_t const& _query, search_t const& _search, std::vector<size_t> const& _partition, delegate_t const& _delegate)
+    Search(index_t const& _index, query_t const& _query, search_t const& _search, std::vector<size_t> const& _partition, delegate_t const& _delegate, stats_t& _stats)
         : index     {_index}
         , query     {_query}
         , search    {_search}
         , partition {_partition}
         , delegate  {_delegate}
+        , stats     {_stats}
     {
         // check how many characters are before the first query char
         for (size_t i{0}; i < search.pi[0]; ++i) {
@@ -77,11 +80,13 @@ struct Search {
     }
 
     auto extend(cursor_t const& cur, uint64_t symb) const noexcept {
+        stats.extendSymb();
         if (dir == dir_t::Right) return cur.extendRight(symb);
         return cur.extendLeft(symb);
     }
 
     auto extend(cursor_t const& cur) const noexcept {
+        stats.extendAll();
         if (dir == dir_t::Right) return cur.extendRight();
         return cur.extendLeft();
     }
@@ -140,6 +145,7 @@ struct Search {
      */
     bool check_and_search_next_symb(cursor_t const& cur) const {
         if (cur.count() == 0) return false;
+        stats.node(search.pi[part]);
         auto r_qp = RestoreAdd{side->queryPos, dir};
         auto r_p  = RestoreSub{partitionPart, 1};
 
@@ -192,6 +198,7 @@ struct Search {
                     auto r_lr = Restore{side->lastRank, i};
                     if (deletionAllowed) {
                         side->info = 'D';
+                        stats.node(search.pi[part]);
                         auto f = search_next_symb(newCur); // deletion occurred in query
                         if (f) return true;
                     }
@@ -237,6 +244,7 @@ struct Search {
             if (cur.count() == 1) {
                 auto s = (dir == dir_t::Right)?cur.symbolRight():cur.symbolLeft();
                 if (s != nextSymb) return false;
+                stats.extendSymb();
                 if constexpr (requires() { { cur.extendRightBySymbol(nextSymb) }; }) {
                     cur = (dir == dir_t::Right)?cur.extendRightBySymbol(nextSymb):cur.extendLeftBySymbol(nextSymb);
                 } else {
@@ -246,6 +254,7 @@ struct Search {
                 cur = extend(cur, nextSymb);
             }
             if (cur.count() == 0) return false; // early abort, if results are empty
+            stats.node(search.pi[part]);
         }
 
         auto r_lr   = Restore{side->lastRank, nextSymb};
@@ -268,6 +277,7 @@ struct Search {
         auto r_p    = Restore{partitionPart};
 
         // detect next symbol/cursor
+        stats.extendSymb();
         auto [curISymb, icursorNext] = [&]() -> std::tuple<size_t, cursor_t> {
             if constexpr (requires() { { cur.extendRightBySymbol() }; }) {
                 if (dir == dir_t::Right) {
@@ -320,6 +330,7 @@ struct Search {
                     auto r_e  = Restore{e, e+1};
                     auto r_lr = Restore{side->lastRank, curISymb};
                     side->info = 'D';
+                    if (icursorNext.count() > 0) stats.node(search.pi[part]);
                     bool f = search_next_symb_single(icursorNext);
                     if (f) return true;
                 }
@@ -342,8 +353,8 @@ struct Search {
 };
 
 
-template <bool Edit, typename index_t, Sequence query_t, typename delegate_t>
-void search_impl(index_t const& index, query_t const& query, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate) {
+template <bool Edit, typename index_t, Sequence query_t, typename delegate_t, typename stats_t = instrumentation::Disabled>
+void search_impl(index_t const& index, query_t const& query, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, stats_t&& stats = {}) {
     using cursor_t = select_cursor_t<index_t>;
     using R = std::decay_t<decltype(delegate(std::declval<cursor_t>(), 0))>;
 
@@ -359,7 +370,7 @@ void search_impl(index_t const& index, query_t const& query, search_scheme::Sche
     }();
 
     for (auto const& search : search_scheme) {
-        bool f = Search<Edit, index_t, query_t, decltype(search), decltype(internal_delegate)>{index, query, search, partition, internal_delegate}.run();
+        bool f = Search<Edit, index_t, query_t, decltype(search), decltype(internal_delegate), std::remove_cvref_t<stats_t>>{index, query, search, partition, internal_delegate, stats}.run();
         if (f) {
             return;
         }
@@ -379,34 +390,44 @@ void search_impl(index_t const& index, query_t const& query, search_scheme::Sche
  *          e:    number of errors that these matches have
  * \param searchSelectSearchScheme_t: callback that helps selecting a proper search scheme, Must accept one parameters: size_t length
  *          length: length of query
+ * \param stats: instrumentation policy, see instrumentation::Counters
  */
-template <bool Edit, typename index_t, Sequences queries_t, typename selectSearchScheme_t, typename delegate_t>
-void search_n_impl(index_t const& index, queries_t&& queries, selectSearchScheme_t&& selectSearchScheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n) {
+template <bool Edit, typename index_t, Sequences queries_t, typename selectSearchScheme_t, typename delegate_t, typename stats_t>
+void search_n_impl(index_t const& index, queries_t&& queries, selectSearchScheme_t&& selectSearchScheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n, stats_t& stats) {
     if (queries.empty()) return;
     if (n == 0) return;
     for (size_t qidx{}; qidx < queries.size(); ++qidx) {
         size_t ct{};
         auto const& search_scheme = selectSearchScheme(queries[qidx].size());
+        stats.beginQuery(qidx, partition.size());
         search_impl<Edit>(index, queries[qidx], search_scheme, partition, [&] (auto cur, size_t e) {
             if (cur.count() + ct > n) {
                 cur.len = n-ct;
             }
             ct += cur.count();
+            stats.result(cur.count());
             delegate(qidx, cur, e);
             return ct == n;
-        });
+        }, stats);
     }
 }
 
 
-// convenience function, with passed search scheme and multiple queries
-template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
-void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+// convenience function, with passed search scheme, multiple queries and instrumentation
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t, instrumentation::Policy stats_t>
+void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, stats_t& stats, size_t n = std::numeric_limits<size_t>::max()) {
     // function that selects a search scheme
     auto selectSearchScheme = [&]([[maybe_unused]] size_t length) -> auto& {
         return search_scheme;
     };
-    search_n_impl<Edit>(index, queries, selectSearchScheme, partition, delegate, n);
+    search_n_impl<Edit>(index, queries, selectSearchScheme, partition, delegate, n, stats);
+}
+
+// convenience function, with passed search scheme and multiple queries
+template <bool Edit=true, typename index_t, Sequences queries_t, typename delegate_t>
+void search(index_t const& index, queries_t&& queries, search_scheme::Scheme const& search_scheme, std::vector<size_t> const& partition, delegate_t&& delegate, size_t n = std::numeric_limits<size_t>::max()) {
+    auto stats = instrumentation::Disabled{};
+    search<Edit>(index, queries, search_scheme, partition, delegate, stats, n);
 }
 
 }
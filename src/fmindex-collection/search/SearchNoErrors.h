@@ -4,18 +4,45 @@
 #pragma once
 
 #include "../concepts.h"
+#include "Deduplicate.h"
 #include "SelectCursor.h"
 
+#include <tuple>
+
 
 namespace fmc::search_no_errors {
 
+namespace detail {
+/** Cursor to start searching `query` from
+ *
+ * If the index has a k-mer lookup table, the cursor of the last k symbols is taken from it.
+ * \return the cursor and the number of symbols of `query` it already represents
+ */
+template <typename cursor_t, typename index_t, typename query_t>
+auto startCursor(index_t const& index, query_t const& query) -> std::tuple<cursor_t, size_t> {
+    if constexpr (requires() { { index.kmerLookup.k }; }) {
+        auto k = index.kmerLookup.k;
+        if (k > 0 && query.size() >= k) {
+            if (auto entry = index.kmerLookup.find(query, query.size() - k)) {
+                auto [lb, lbRev, len] = *entry;
+                return {cursor_t{index, lb, len, k}, k};
+            }
+        }
+    }
+    return {cursor_t{index}, 0};
+}
+}
+
 template <typename index_t, Sequence query_t>
 auto search(index_t const & index, query_t const& query) {
     using cursor_t = select_left_cursor_t<index_t>;
     static_assert(not cursor_t::Reversed, "reversed fmindex is not supported");
 
-    auto cur = cursor_t{index};
-    for (size_t i{0}; i < query.size(); ++i) {
+    auto [cur, start] = detail::startCursor<cursor_t>(index, query);
+    if (cur.empty()) {
+        return cur;
+    }
+    for (size_t i{start}; i < query.size(); ++i) {
         auto r = query[query.size() - i - 1];
         cur = cur.extendLeft(r);
         if (cur.empty()) {
@@ -25,20 +52,57 @@ auto search(index_t const & index, query_t const& query) {
     return cur;
 }
 
+/** Searches multiple queries without errors
+ *
+ * Up to `BatchSize` queries are extended in an interleaved fashion. After a
+ * cursor has been extended, the memory required for its next extension is
+ * prefetched (if the bwt string supports `prefetch`), which gives the data time
+ * to arrive while the other cursors of the batch are processed.
+ * Finished queries are immediately replaced by the next pending query, keeping
+ * the batch full.
+ *
+ * \param index     index to search in
+ * \param queries   queries to search for
+ * \param delegate  callback `(size_t qidx, cursor_t const& cursor)`, called for each query that was found
+ * \param BatchSize number of queries that are processed interleaved
+ */
 template <typename index_t, Sequences queries_t, typename delegate_t>
 void search(index_t const & index, queries_t const& queries, delegate_t && delegate, size_t const BatchSize = 32) {
     using cursor_t = select_left_cursor_t<index_t>;
     static_assert(not cursor_t::Reversed, "reversed fmindex is not supported");
 
+    constexpr bool static HasPrefetch = requires(index_t const& _index) {
+        { _index.bwt.prefetch(size_t{}) };
+    };
+    // requests the memory that the next extension of `cur` will access
+    auto prefetch = [&](cursor_t const& cur) {
+        if constexpr (HasPrefetch) {
+            index.bwt.prefetch(cur.lb);
+            index.bwt.prefetch(cur.lb + cur.len);
+        }
+    };
 
-    auto queryIndices = std::vector<std::tuple<size_t, cursor_t>>{};
+    auto batch = std::vector<std::tuple<size_t, cursor_t>>{};
+    batch.reserve(BatchSize);
     size_t lastEntry = 0;
 
-    auto fillBatch = [&]() {
-        while (queryIndices.size() < BatchSize && lastEntry < queries.size()) {
-            queryIndices.emplace_back(lastEntry, cursor_t{index});
-            ++lastEntry;
+    // loads the next pending query into `slot`, returns false if no queries are left
+    auto loadNext = [&](std::tuple<size_t, cursor_t>& slot) -> bool {
+        while (lastEntry < queries.size()) {
+            auto qidx = lastEntry++;
+            auto [cur, steps] = detail::startCursor<cursor_t>(index, queries[qidx]);
+            if (queries[qidx].size() == steps) { // nothing to extend, report directly
+                if (!cur.empty()) {
+                    delegate(qidx, cur);
+                }
+                continue;
+            }
+            if (cur.empty()) continue;
+            prefetch(cur);
+            slot = {qidx, cur};
+            return true;
         }
+        return false;
     };
 
     constexpr bool static HasKStep = requires() {
@@ -47,42 +111,71 @@ void search(index_t const & index, queries_t const& queries, delegate_t && deleg
     constexpr size_t static KStep = []() constexpr -> size_t { if constexpr(HasKStep) return index_t::KStep; return 1ul; }();
 
     auto buffer = std::array<size_t, KStep>{};
-    auto doBatchJump = [&]() {
-        for (auto& [qidx, cur] : queryIndices) {
-            auto const& query = queries[qidx];
-            if constexpr (HasKStep) {
-                if (query.size() - cur.steps >= KStep) {
-                    for (size_t j{0}; j < KStep; ++j) {
-                        buffer[j] = query[query.size() - cur.steps - 1 - j];
-                    }
-                    cur = cur.extendLeftKStep(buffer);
-                } else {
-                    auto sym = query[query.size() - cur.steps - 1];
-                    cur = cur.extendLeft(sym);
+    auto extend = [&](auto const& query, cursor_t const& cur) -> cursor_t {
+        if constexpr (HasKStep) {
+            if (query.size() - cur.steps >= KStep) {
+                for (size_t j{0}; j < KStep; ++j) {
+                    buffer[j] = query[query.size() - cur.steps - 1 - j];
                 }
-            } else {
-                auto sym = query[query.size() - cur.steps - 1];
-                cur = cur.extendLeft(sym);
+                return cur.extendLeftKStep(buffer);
             }
+        }
+        auto sym = query[query.size() - cur.steps - 1];
+        return cur.extendLeft(sym);
+    };
 
+    while (batch.size() < BatchSize) {
+        batch.emplace_back();
+        if (!loadNext(batch.back())) {
+            batch.pop_back();
+            break;
         }
-        queryIndices.erase(std::remove_if(begin(queryIndices), end(queryIndices), [&](auto const& v) {
-            auto const& [qidx, cur] = v;
+    }
+
+    while (!batch.empty()) {
+        for (size_t i{0}; i < batch.size();) {
+            auto& [qidx, cur] = batch[i];
             auto const& query = queries[qidx];
-            if (cur.count() == 0) return true;
-            if (query.size() == cur.steps) {
+            cur = extend(query, cur);
+            if (!cur.empty() && query.size() != cur.steps) {
+                prefetch(cur);
+                ++i;
+                continue;
+            }
+            if (!cur.empty()) {
                 delegate(qidx, cur);
-                return true;
             }
-            return false;
-        }), end(queryIndices));
-    };
-
-    fillBatch();
-    while (!queryIndices.empty()) {
-        doBatchJump();
-        fillBatch();
+            if (loadNext(batch[i])) {
+                ++i;
+                continue;
+            }
+            // no pending queries, shrink the batch
+            batch[i] = batch.back();
+            batch.pop_back();
+        }
     }
 }
 
+/** Searches multiple queries without errors, each group of identical queries only once
+ *
+ * Same as search(index, queries, delegate), but only the representative of each group is searched.
+ * `delegate(qidx, cursor)` is called for every member of a group that was found, group by group.
+ *
+ * \param groups    grouping of `queries`, see groupQueries
+ */
+template <typename index_t, Sequences queries_t, typename delegate_t>
+void search_deduplicated(index_t const& index, queries_t const& queries, QueryGroups const& groups, delegate_t&& delegate, size_t const BatchSize = 32) {
+    search(index, representativeQueries(queries, groups), [&](size_t group, auto const& cursor) {
+        for (auto qidx : groups.membersOf(group)) {
+            delegate(qidx, cursor);
+        }
+    }, BatchSize);
+}
+
+//!\brief same as above, identical queries are grouped via groupQueries(queries)
+template <typename index_t, Sequences queries_t, typename delegate_t>
+void search_deduplicated(index_t const& index, queries_t const& queries, delegate_t&& delegate, size_t const BatchSize = 32) {
+    search_deduplicated(index, queries, groupQueries(queries), delegate, BatchSize);
+}
+
 }
@@ -0,0 +1,231 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "../concepts.h"
+#include "../parallel.h"
+#include "SelectCursor.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <ranges>
+#include <tuple>
+#include <vector>
+
+/**
+ * Seeding by super-maximal exact matches (SMEMs)
+ *
+ * A maximal exact match (MEM) is a substring `query[begin, end)` that occurs in the index and that
+ * can not be extended to the left or to the right without losing occurrences. A SMEM is a MEM
+ * that is not contained in any other MEM of the same query. With `minOcc > 1`, only substrings
+ * occurring at least `minOcc` times count as matches.
+ *
+ * SMEMs are computed with the forward/backward algorithm of bwa-mem (Li, 2012) on a bidirectional
+ * cursor: starting at position x, the match is extended to the right, remembering each cursor
+ * whose count changes. These cursors are then extended to the left, all together, and each
+ * cursor that can not be extended any further is reported, unless a longer match was already
+ * reported at this step. The search continues at the end of the longest match to the right.
+ *
+ * Re-seeding (optional): long SMEMs with few occurrences may hide the true locus of a read.
+ * Each of them is searched again from its middle, requiring one more occurrence than the SMEM
+ * itself has, which yields shorter MEMs with more occurrences.
+ *
+ * Each seed carries its cursor, seeds can be located via LocateLinear or locateBatch.
+ */
+namespace fmc::seeding {
+
+struct Options {
+    size_t minLength{19};                             // shorter seeds are not reported
+    size_t minOcc{1};                                 // a match must occur at least this often
+    size_t maxOcc{std::numeric_limits<size_t>::max()}; // seeds occurring more often are not reported
+    bool   reseed{false};                             // search long seeds again (see above)
+    size_t reseedLength{28};                          // seeds of at least this length are searched again
+    size_t reseedMaxOcc{10};                          // only seeds with at most this many occurrences are searched again
+};
+
+template <typename cursor_t>
+struct Seed {
+    size_t   begin;  // first position inside the query
+    size_t   end;    // one after the last position inside the query
+    cursor_t cursor; // all occurrences of `query[begin, end)`
+
+    size_t length() const {
+        return end - begin;
+    }
+    size_t count() const {
+        return cursor.count();
+    }
+};
+
+namespace detail {
+
+/** Computes all SMEMs containing position `_x`
+ *
+ * Appends the SMEMs to `_seeds` (ignoring `minLength`), in decreasing order of `begin`.
+ * \return the end of the longest match starting at `_x`, where the next search should start
+ */
+template <typename index_t, typename query_t, typename cursor_t>
+size_t smemsAt(index_t const& _index, query_t const& _query, size_t _x, size_t _minOcc, std::vector<Seed<cursor_t>>& _seeds) {
+    struct Match {
+        cursor_t cursor;
+        size_t   end;
+    };
+    // symbols below FirstSymb are delimiters (indices without delimiters have FirstSymb == 0)
+    constexpr static size_t FirstSymb = []() -> size_t {
+        if constexpr (requires() { { index_t::FirstSymb }; }) {
+            return index_t::FirstSymb;
+        }
+        return 1;
+    }();
+
+    auto const n = _query.size();
+    auto validSymb = [&](size_t pos) {
+        auto s = static_cast<size_t>(_query[pos]);
+        return s >= FirstSymb && s < index_t::Sigma;
+    };
+    if (!validSymb(_x)) {
+        return _x + 1;
+    }
+
+    auto cursor = cursor_t{_index}.extendRight(_query[_x]);
+    if (cursor.count() < _minOcc) {
+        return _x + 1;
+    }
+
+    // forward extension, the cursors are stored with increasing length
+    auto matches = std::vector<Match>{};
+    size_t i{_x + 1};
+    for (; i < n; ++i) {
+        auto next = validSymb(i) ? cursor.extendRight(_query[i]) : cursor_t{};
+        if (next.count() != cursor.count()) {
+            matches.push_back({cursor, i});
+        }
+        if (next.count() < _minOcc) break;
+        cursor = next;
+    }
+    if (i == n) {
+        matches.push_back({cursor, n});
+    }
+    auto ret = matches.back().end;
+    std::ranges::reverse(matches); // longest match first
+
+    // backward extension of all matches at once, `pos` is the begin of the current matches
+    auto next = std::vector<Match>{};
+    auto lastBegin = std::optional<size_t>{};
+    for (size_t pos{_x}; !matches.empty(); --pos) {
+        bool canExtend = pos > 0 && validSymb(pos-1);
+        next.clear();
+        for (auto const& m : matches) {
+            auto ext = canExtend ? m.cursor.extendLeft(_query[pos-1]) : cursor_t{};
+            if (ext.count() < _minOcc) {
+                // m is maximal, report it if no longer match was reported at this step
+                if (next.empty() && (!lastBegin || pos < *lastBegin)) {
+                    _seeds.push_back({pos, m.end, m.cursor});
+                    lastBegin = pos;
+                }
+            } else if (next.empty() || ext.count() != next.back().cursor.count()) {
+                next.push_back({ext, m.end});
+            }
+        }
+        std::swap(matches, next);
+    }
+    return ret;
+}
+
+}
+
+/** Computes all seeds of a single query
+ *
+ * \param _index   a bidirectional index
+ * \param _query   the query
+ * \param _options see Options
+ * \return seeds sorted by (begin, end)
+ */
+template <typename index_t, Sequence query_t>
+auto smems(index_t const& _index, query_t const& _query, Options const& _options = {}) {
+    using cursor_t = select_cursor_t<index_t>;
+    static_assert(requires(cursor_t c) {
+        { c.extendLeft(size_t{}) };
+        { c.extendRight(size_t{}) };
+    }, "seeding requires a bidirectional index");
+
+    auto candidates = std::vector<Seed<cursor_t>>{};
+    for (size_t x{0}; x < _query.size();) {
+        x = detail::smemsAt<index_t, query_t, cursor_t>(_index, _query, x, _options.minOcc, candidates);
+    }
+    std::erase_if(candidates, [&](auto const& seed) {
+        return seed.length() < _options.minLength;
+    });
+
+    if (_options.reseed) {
+        auto const smemCt = candidates.size();
+        auto reseeds = std::vector<Seed<cursor_t>>{};
+        for (size_t i{0}; i < smemCt; ++i) {
+            auto const& seed = candidates[i];
+            if (seed.length() < _options.reseedLength || seed.count() > _options.reseedMaxOcc) continue;
+            reseeds.clear();
+            detail::smemsAt<index_t, query_t, cursor_t>(_index, _query, (seed.begin + seed.end) / 2, seed.count()+1, reseeds);
+            for (auto const& r : reseeds) {
+                if (r.length() >= _options.minLength) {
+                    candidates.push_back(r);
+                }
+            }
+        }
+    }
+
+    std::ranges::sort(candidates, [](auto const& lhs, auto const& rhs) {
+        return std::tie(lhs.begin, lhs.end, lhs.cursor.lb) < std::tie(rhs.begin, rhs.end, rhs.cursor.lb);
+    });
+    auto [first, last] = std::ranges::unique(candidates, [](auto const& lhs, auto const& rhs) {
+        return lhs.begin == rhs.begin && lhs.end == rhs.end;
+    });
+    candidates.erase(first, last);
+    std::erase_if(candidates, [&](auto const& seed) {
+        return seed.count() > _options.maxOcc;
+    });
+    return candidates;
+}
+
+/** Computes the seeds of multiple queries
+ *
+ * Calls `_delegate(qidx, seed)` for each seed, query by query.
+ */
+template <typename index_t, Sequences queries_t, typename delegate_t>
+void smems(index_t const& _index, queries_t const& _queries, Options const& _options, delegate_t&& _delegate) {
+    for (size_t qidx{0}; qidx < _queries.size(); ++qidx) {
+        for (auto const& seed : smems(_index, _queries[qidx], _options)) {
+            _delegate(qidx, seed);
+        }
+    }
+}
+
+/** Computes the seeds of multiple queries in parallel
+ *
+ * Same as `smems(index, queries, options, delegate)`, the queries are distributed in chunks
+ * over `_threadNbr` threads. Seeds are reported in the same order as by a single thread,
+ * `_delegate` is never called concurrently.
+ *
+ * \param _threadNbr number of threads
+ * \param _chunkSize number of queries that are processed as one unit of work
+ */
+template <typename index_t, Sequences queries_t, typename delegate_t>
+void smems_parallel(index_t const& _index, queries_t const& _queries, Options const& _options, size_t _threadNbr, delegate_t&& _delegate, size_t _chunkSize = 256) {
+    using cursor_t = select_cursor_t<index_t>;
+    using Result   = std::tuple<size_t, Seed<cursor_t>>;
+
+    parallelBatch<Result>(_queries.size(), _threadNbr, _chunkSize, [&](size_t begin, size_t end, std::vector<Result>& buffer) {
+        for (size_t qidx{begin}; qidx < end; ++qidx) {
+            for (auto const& seed : smems(_index, _queries[qidx], _options)) {
+                buffer.emplace_back(qidx, seed);
+            }
+        }
+    }, [&](std::vector<Result> const& buffer) {
+        for (auto const& [qidx, seed] : buffer) {
+            _delegate(qidx, seed);
+        }
+    });
+}
+
+}
@@ -5,8 +5,10 @@
 
 #include "Backtracking.h"
 #include "BacktrackingWithBuffers.h"
+#include "Deduplicate.h"
 #include "SearchDoubleIndex.h"
 #include "SearchDoubleIndex2.h"
+#include "SearchHybrid.h"
 #include "SearchNg12.h"
 #include "SearchNg14.h"
 #include "SearchNg15.h"
@@ -31,5 +33,6 @@
 #include "SearchNg28Options.h"
 #include "SearchPseudo.h"
 #include "SearchNoErrors.h"
+#include "Seeding.h"
 #include "SearchOneError.h"
 #include "search.h"
@@ -3,6 +3,7 @@
 #pragma once
 
 #include "../locate.h"
+#include "../parallel.h"
 #include "SearchNg24.h"
 #include "SearchNg25.h"
 #include "SearchNg26.h"
@@ -44,6 +45,108 @@ void search_n(index_t const& _index, queries_t const& _queries, size_t _errors,
     search_ng26::search<EditDistance>(_index, _queries, _errors, std::forward<delegate_t>(_delegate), _n);
 }
 
+/** Searches all queries, each group of identical queries only once
+ *
+ * Same as `search(index, queries, errors, delegate)`, but only the representative of each group
+ * is searched and its results are passed on to all members of the group, group by group.
+ * With a grouping that includes reverse complements, `_groups.reverseComplement[qidx]` tells
+ * whether the reported cursor belongs to the reverse complement of `qidx`.
+ *
+ * \param _groups grouping of `_queries`, see groupQueries
+ */
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_deduplicated(index_t const& _index, queries_t const& _queries, size_t _errors, QueryGroups const& _groups, delegate_t&& _delegate) {
+    search<EditDistance>(_index, representativeQueries(_queries, _groups), _errors, [&](size_t group, auto const& cursor, size_t errors) {
+        for (auto qidx : _groups.membersOf(group)) {
+            _delegate(qidx, cursor, errors);
+        }
+    });
+}
+
+//!\brief same as above, identical queries are grouped via groupQueries(queries)
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_deduplicated(index_t const& _index, queries_t const& _queries, size_t _errors, delegate_t&& _delegate) {
+    search_deduplicated<EditDistance>(_index, _queries, _errors, groupQueries(_queries), _delegate);
+}
+
+//!\brief same as search_deduplicated, reporting at most `_n` results per query
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_n_deduplicated(index_t const& _index, queries_t const& _queries, size_t _errors, size_t _n, QueryGroups const& _groups, delegate_t&& _delegate) {
+    search_n<EditDistance>(_index, representativeQueries(_queries, _groups), _errors, _n, [&](size_t group, auto const& cursor, size_t errors) {
+        for (auto qidx : _groups.membersOf(group)) {
+            _delegate(qidx, cursor, errors);
+        }
+    });
+}
+
+//!\brief same as above, identical queries are grouped via groupQueries(queries)
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_n_deduplicated(index_t const& _index, queries_t const& _queries, size_t _errors, size_t _n, delegate_t&& _delegate) {
+    search_n_deduplicated<EditDistance>(_index, _queries, _errors, _n, groupQueries(_queries), _delegate);
+}
+
+/** Searches all queries in parallel
+ *
+ * Same as `search(index, queries, errors, delegate)`, but the queries are distributed in chunks
+ * over `_threadNbr` threads. Results are buffered per chunk and passed on to `_delegate` in the
+ * same order a single threaded search would report them. `_delegate` is never called concurrently.
+ *
+ * \param _threadNbr number of threads used for searching
+ * \param _chunkSize number of queries that are searched as one unit of work
+ */
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_parallel(index_t const& _index, queries_t const& _queries, size_t _errors, size_t _threadNbr, delegate_t&& _delegate, size_t _chunkSize = 256) {
+    auto queryBegin = std::ranges::begin(_queries);
+    auto chunkOf = [&](size_t begin, size_t end) {
+        return std::ranges::subrange(queryBegin + begin, queryBegin + end);
+    };
+    auto report = [&](auto const& buffer) {
+        for (auto const& [qidx, cursor, errors] : buffer) {
+            _delegate(qidx, cursor, errors);
+        }
+    };
+
+    if (_errors == 0) {
+        using cursor_t = select_left_cursor_t<index_t>;
+        using Result   = std::tuple<size_t, cursor_t, size_t>;
+        parallelBatch<Result>(_queries.size(), _threadNbr, _chunkSize, [&](size_t begin, size_t end, std::vector<Result>& buffer) {
+            search_no_errors::search(_index, chunkOf(begin, end), [&](size_t qidx, auto const& cursor) {
+                buffer.emplace_back(begin + qidx, cursor, size_t{0});
+            });
+        }, report);
+    } else {
+        using cursor_t = select_cursor_t<index_t>;
+        using Result   = std::tuple<size_t, cursor_t, size_t>;
+        parallelBatch<Result>(_queries.size(), _threadNbr, _chunkSize, [&](size_t begin, size_t end, std::vector<Result>& buffer) {
+            search_ng26::search<EditDistance>(_index, chunkOf(begin, end), _errors, [&](size_t qidx, auto const& cursor, size_t errors) {
+                buffer.emplace_back(begin + qidx, cursor, errors);
+            });
+        }, report);
+    }
+}
+
+/** Searches all queries in parallel, reporting at most `_n` results per query
+ *
+ * see search_parallel
+ */
+template <bool EditDistance, typename index_t, Sequences queries_t, typename delegate_t>
+void search_n_parallel(index_t const& _index, queries_t const& _queries, size_t _errors, size_t _n, size_t _threadNbr, delegate_t&& _delegate, size_t _chunkSize = 256) {
+    using cursor_t = select_cursor_t<index_t>;
+    using Result   = std::tuple<size_t, cursor_t, size_t>;
+
+    auto queryBegin = std::ranges::begin(_queries);
+    parallelBatch<Result>(_queries.size(), _threadNbr, _chunkSize, [&](size_t begin, size_t end, std::vector<Result>& buffer) {
+        auto chunk = std::ranges::subrange(queryBegin + begin, queryBegin + end);
+        search_ng26::search<EditDistance>(_index, chunk, _errors, [&](size_t qidx, auto const& cursor, size_t errors) {
+            buffer.emplace_back(begin + qidx, cursor, errors);
+        }, _n);
+    }, [&](auto const& buffer) {
+        for (auto const& [qidx, cursor, errors] : buffer) {
+            _delegate(qidx, cursor, errors);
+        }
+    });
+}
+
 template <typename index_t, Sequences queries_t, typename delegate_t>
 struct Search {
     index_t const&        index;
@@ -51,8 +154,13 @@ struct Search {
     bool                  editDistance{true};
     size_t                errors{0};
     std::optional<size_t> maxResults{};
+    size_t                threadNbr{1};
     delegate_t const&     reportFunc;
     void operator()() {
+        if (threadNbr > 1) {
+            runParallel();
+            return;
+        }
         auto report = [&](size_t qidx, auto const& cursor, size_t errors) {
             for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
                 reportFunc(qidx, sid, spos+offset, errors);
@@ -72,6 +180,39 @@ struct Search {
             }
         }
     }
+
+private:
+    // searches and locates in parallel, reports (qidx, seqId, pos, errors) in query order
+    void runParallel() {
+        using Result = std::tuple<size_t, size_t, size_t, size_t>;
+
+        auto queryBegin = std::ranges::begin(queries);
+        parallelBatch<Result>(queries.size(), threadNbr, /*.chunkSize=*/256, [&](size_t begin, size_t end, std::vector<Result>& buffer) {
+            auto chunk = std::ranges::subrange(queryBegin + begin, queryBegin + end);
+            auto locate = [&](size_t qidx, auto const& cursor, size_t errors) {
+                for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                    buffer.emplace_back(begin + qidx, sid, spos+offset, errors);
+                }
+            };
+            if (maxResults) {
+                if (editDistance) {
+                    search_n<true>(index, chunk, errors, *maxResults, locate);
+                } else {
+                    search_n<false>(index, chunk, errors, *maxResults, locate);
+                }
+            } else {
+                if (editDistance) {
+                    search<true>(index, chunk, errors, locate);
+                } else {
+                    search<false>(index, chunk, errors, locate);
+                }
+            }
+        }, [&](std::vector<Result> const& buffer) {
+            for (auto const& [qidx, sid, spos, errors] : buffer) {
+                reportFunc(qidx, sid, spos, errors);
+            }
+        });
+    }
 };
 
 }
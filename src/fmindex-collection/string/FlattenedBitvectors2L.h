@@ -3,6 +3,8 @@
 #pragma once
 
 #include "../bitset_popcount.h"
+#include "../builtins.h"
+#include "../parallel.h"
 #include "../ternarylogic.h"
 #include "../utils.h"
 #include "EPRV3.h"
@@ -121,6 +123,60 @@ struct FlattenedBitvectors2L {
         : FlattenedBitvectors2L{internal_tag{}, _symbols}
     {}
 
+    /** Constructs the string on multiple threads
+     *
+     * Each l0 block only depends on its own symbols, so all blocks are filled
+     * concurrently. Only the l0 prefix sums are computed afterwards in a single pass.
+     */
+    template <std::ranges::random_access_range range_t>
+        requires (std::ranges::sized_range<range_t> && std::convertible_to<std::ranges::range_value_t<range_t>, uint64_t>)
+    FlattenedBitvectors2L(range_t&& _symbols, size_t _threadNbr) {
+        constexpr size_t l1_block_ct = l0_bits_ct / l1_bits_ct;
+
+        totalLength = _symbols.size();
+        size_t l0BlockCt = (totalLength / l0_bits_ct) + 1;
+        l0.resize(l0BlockCt);
+        l1.resize(l0BlockCt * l1_block_ct);
+        bits.resize(l0BlockCt * l1_block_ct);
+
+        // number of symbols smaller than `symb` in each l0 block
+        auto blockAcc = std::vector<BlockL0>(l0BlockCt);
+
+        parallelFor(l0BlockCt, _threadNbr, /*.chunkSize=*/1, [&](size_t begin, size_t end) {
+            for (size_t l0I{begin}; l0I < end; ++l0I) {
+                auto firstIdx = l0I * l0_bits_ct;
+                auto lastIdx  = std::min(firstIdx + l0_bits_ct, totalLength);
+                for (size_t idx{firstIdx}; idx < lastIdx; ++idx) {
+                    bits[idx / l1_bits_ct].setSymbol(idx % l1_bits_ct, _symbols[idx]);
+                }
+
+                BlockL0 acc{};
+                for (size_t i{0}; i < l1_block_ct; ++i) {
+                    auto idx = l0I*l1_block_ct + i;
+                    for (size_t symb{0}; symb <= TSigma; ++symb) {
+                        l1[idx][symb] = acc[symb];
+                    }
+                    auto counts = bits[idx].all_ranks(l1_bits_ct);
+
+                    size_t a{};
+                    for (size_t symb{0}; symb < TSigma; ++symb) {
+                        a += counts[symb];
+                        acc[symb+1] += a;
+                    }
+                }
+                blockAcc[l0I] = acc;
+            }
+        });
+
+        BlockL0 l0_acc{};
+        for (size_t l0I{0}; l0I < l0BlockCt; ++l0I) {
+            l0[l0I] = l0_acc;
+            for (size_t symb{0}; symb <= TSigma; ++symb) {
+                l0_acc[symb] += blockAcc[l0I][symb];
+            }
+        }
+    }
+
 private:
     struct internal_tag{};
 
@@ -207,6 +263,22 @@ public:
     }
 public:
 
+    /** Requests all memory touched by rank(idx, ...) without waiting for it
+     *
+     * Allows interleaving the rank queries of multiple cursors, so their cache
+     * misses overlap instead of being resolved one after another.
+     */
+    void prefetch(uint64_t idx) const {
+        auto l1Id = idx / l1_bits_ct;
+        auto l0Id = idx / l0_bits_ct;
+        __builtin_prefetch(reinterpret_cast<void const*>(&l0[l0Id]), 0, 0);
+        __builtin_prefetch(reinterpret_cast<void const*>(&l1[l1Id]), 0, 0);
+        auto ptr = reinterpret_cast<char const*>(&bits[l1Id]);
+        for (size_t i{0}; i < sizeof(InBits); i += 64) {
+            __builtin_prefetch(reinterpret_cast<void const*>(ptr + i), 0, 0);
+        }
+    }
+
     uint64_t rank(uint64_t idx, uint64_t symb) const {
         assert(idx <= totalLength);
         assert(symb < Sigma);
@@ -770,10 +770,8 @@ public:
         auto const& bits_lb = bits[l1Id_lb].bits;
         auto const& bits_rb = bits[l1Id_rb].bits;
 
-        // computes prefix rank for symbol (symb)
-        auto count_pr = [&](auto const& b1, auto const& b2, size_t symb) -> std::tuple<size_t, size_t> {
-            auto count_lb = skip_first_or_last_n_bits_and_count(b1, bitId_lb);
-            auto count_rb = skip_first_or_last_n_bits_and_count(b2, bitId_rb);
+        // computes prefix rank for symbol (symb), given the counts inside the l1 blocks
+        auto count_pr = [&](size_t count_lb, size_t count_rb, size_t symb) -> std::tuple<size_t, size_t> {
 
             auto pr1 = [&]() {
                 auto const& superblock = (symb>0)?l0_lb[symb-1]:size_t{0};
@@ -869,10 +867,11 @@ public:
          */
         auto rec = [&](this auto&& self, word_of_bits const& l_b1, word_of_bits const& r_b1, word_of_bits const& l_b2, word_of_bits const& r_b2, int level, size_t pr1_S, size_t pr2_S, size_t pr1_E, size_t pr2_E, size_t symb) -> void {
             auto lsymb = symb | (1 << level);
-            auto b1 = l_b1 | (r_b1 & ~bits_lb[level]);
-            auto b2 = l_b2 | (r_b2 & ~bits_rb[level]);
+            // b = l_b | (r_b & ~bits[level]), counted inside the masked range (see rank_kernels.h)
+            auto [b1, count_lb] = rank_kernels::orAndNotCount(l_b1, r_b1, bits_lb[level], skip_first_or_last_n_bits_masks<l1_bits_ct>[bitId_lb]);
+            auto [b2, count_rb] = rank_kernels::orAndNotCount(l_b2, r_b2, bits_rb[level], skip_first_or_last_n_bits_masks<l1_bits_ct>[bitId_rb]);
 
-            auto [pr1, pr2] = count_pr(b1, b2, lsymb);
+            auto [pr1, pr2] = count_pr(count_lb, count_rb, lsymb);
 
             assert(This->prefix_rank(idx1, lsymb) == pr1);
             assert(This->prefix_rank(idx2, lsymb) == pr2);
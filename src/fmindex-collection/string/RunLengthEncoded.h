@@ -0,0 +1,164 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include "FlattenedBitvectors2L.h"
+#include "concepts.h"
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <mmser/mmser.h>
+#include <span>
+#include <vector>
+
+#if __has_include(<cereal/types/array.hpp>)
+#include <cereal/types/array.hpp>
+#endif
+
+namespace fmc::string {
+
+/**
+ * A run length encoded string (as used by the r-index)
+ *
+ * The string is stored as a sequence of r runs. Space is O(r) instead of O(n),
+ * which pays off for highly repetitive texts, e.g. many genomes of the same species.
+ * - `heads` stores one symbol per run and supports rank over runs
+ * - `runStarts` stores the first position of each run
+ * - `runLengths[c][k]` stores the total length of the first k runs of symbol c
+ *
+ * A rank query finds the run of a position by binary search (O(log r)) followed
+ * by a rank on `heads`.
+ */
+template <size_t TSigma, template <size_t> typename HeadString = FlattenedBitvectors_512_64k>
+struct RunLengthEncoded {
+    static constexpr size_t Sigma = TSigma;
+
+    HeadString<TSigma>                         heads;
+    mmser::vector<uint64_t>                    runStarts{0}; // last entry is the size of the string
+    std::array<mmser::vector<uint64_t>, Sigma> runLengths;
+
+    RunLengthEncoded() {
+        for (auto& l : runLengths) {
+            l.push_back(0);
+        }
+    }
+
+    RunLengthEncoded(std::span<uint8_t const> _symbols)
+        : RunLengthEncoded{}
+    {
+        auto headSymbols = std::vector<uint8_t>{};
+        // runStarts already contains 0, the start of the first run
+        for (size_t i{0}; i < _symbols.size(); ++i) {
+            if (i == 0 || _symbols[i] != _symbols[i-1]) {
+                headSymbols.push_back(_symbols[i]);
+                if (i > 0) {
+                    runStarts.push_back(i);
+                }
+            }
+        }
+        if (!_symbols.empty()) {
+            runStarts.push_back(_symbols.size());
+        }
+
+        for (size_t j{0}; j < headSymbols.size(); ++j) {
+            auto& l = runLengths[headSymbols[j]];
+            l.push_back(l.back() + runStarts[j+1] - runStarts[j]);
+        }
+        heads = HeadString<TSigma>{headSymbols};
+    }
+
+    size_t size() const {
+        return runStarts.back();
+    }
+
+    //!\brief number of runs
+    size_t runs() const {
+        return runStarts.size() - 1;
+    }
+
+    //!\brief index of the run containing position `idx`
+    size_t findRun(uint64_t idx) const {
+        assert(idx < size());
+        // binary search for the last run starting at or before idx
+        size_t lb{0}, ub{runs()};
+        while (ub - lb > 1) {
+            auto mid = lb + (ub - lb) / 2;
+            if (runStarts[mid] <= idx) {
+                lb = mid;
+            } else {
+                ub = mid;
+            }
+        }
+        return lb;
+    }
+
+    uint8_t symbol(uint64_t idx) const {
+        assert(idx < size());
+        return heads.symbol(findRun(idx));
+    }
+
+    uint64_t rank(uint64_t idx, uint64_t symb) const {
+        assert(idx <= size());
+        assert(symb < Sigma);
+        if (idx == size()) {
+            return runLengths[symb].back();
+        }
+        auto run = findRun(idx);
+        auto v   = runLengths[symb][heads.rank(run, symb)];
+        if (heads.symbol(run) == symb) {
+            v += idx - runStarts[run];
+        }
+        return v;
+    }
+
+    uint64_t prefix_rank(uint64_t idx, uint64_t symb) const {
+        assert(idx <= size());
+        assert(symb <= Sigma);
+        auto rs = all_ranks(idx);
+        uint64_t acc{};
+        for (size_t i{0}; i < symb; ++i) {
+            acc += rs[i];
+        }
+        return acc;
+    }
+
+    auto all_ranks(uint64_t idx) const -> std::array<uint64_t, TSigma> {
+        assert(idx <= size());
+        auto rs = std::array<uint64_t, TSigma>{};
+        if (idx == size()) {
+            for (size_t i{0}; i < TSigma; ++i) {
+                rs[i] = runLengths[i].back();
+            }
+            return rs;
+        }
+        auto run = findRun(idx);
+        auto runRanks = heads.all_ranks(run);
+        for (size_t i{0}; i < TSigma; ++i) {
+            rs[i] = runLengths[i][runRanks[i]];
+        }
+        rs[heads.symbol(run)] += idx - runStarts[run];
+        return rs;
+    }
+
+    auto all_ranks_and_prefix_ranks(uint64_t idx) const -> std::tuple<std::array<uint64_t, TSigma>, std::array<uint64_t, TSigma>> {
+        assert(idx <= size());
+
+        auto rs = all_ranks(idx);
+        auto prs = std::array<uint64_t, TSigma>{};
+        for (size_t i{1}; i < TSigma; ++i) {
+            prs[i] = prs[i-1] + rs[i-1];
+        }
+        return {rs, prs};
+    }
+
+    template <typename Archive>
+    void serialize(this auto&& self, Archive& ar) {
+        ar(self.heads, self.runStarts, self.runLengths);
+    }
+};
+
+template <size_t Sigma> using RunLengthEncoded_512_64k = RunLengthEncoded<Sigma, FlattenedBitvectors_512_64k>;
+static_assert(checkString_c<RunLengthEncoded_512_64k>);
+
+}
@@ -25,6 +25,7 @@
 #include "PartialPairedL0L1L2_NEPRV8.h"
 #include "RunBlockEncoding.h"
 #include "RunBlockEncodingV2.h"
+#include "RunLengthEncoded.h"
 #include "Sdsl_wt_bldc.h"
 #include "Sdsl_wt_epr.h"
 #include "Wavelet.h"
@@ -9,44 +9,55 @@
 
 #include <algorithm>
 #include <cmath>
+#include <mmser/mmser.h>
 #include <numeric>
 #include <optional>
 #include <tuple>
+#include <vector>
 
 
 namespace fmc {
 
 namespace suffixarray {
-template <typename T, typename SAEntry, Bitvector_c Bitvector>
+template <Bitvector_c OutBitvector = bitvector::Bitvector2L<512, 65536>, typename T, typename SAEntry, Bitvector_c Bitvector>
 auto createSampling(std::vector<SAEntry> const& sa,
                     Bitvector const& textAnnotationValid,
-                    std::vector<T> const& textAnnotation) -> std::pair<bitvector::Bitvector2L<512, 65536>, std::vector<T>> {
-    auto bv  = bitvector::Bitvector2L<512, 65536>{};
-    auto ssa = std::vector<T>{};
+                    std::vector<T> const& textAnnotation) -> std::pair<OutBitvector, mmser::vector<T>> {
+    auto marks = std::vector<uint8_t>{};
+    auto ssa   = mmser::vector<T>{};
+    marks.reserve(sa.size());
     for (size_t i{0}; i < sa.size(); ++i) {
         auto textPos = sa[i];
         auto valid = textAnnotationValid.symbol(textPos);
-        bv.push_back(valid);
+        marks.push_back(valid);
         if (valid) {
             auto rank = textAnnotationValid.rank(textPos);
             ssa.push_back(textAnnotation[rank]);
         }
     }
-    return {bv, ssa};
+    return {OutBitvector{marks}, ssa};
 }
 }
 
-struct CSA {
-    using Bitvector = bitvector::Bitvector2L<512, 65536>;
-    std::vector<uint64_t> ssa;
+/**
+ * Sampled suffix array, the sampled rows are marked in a `TBitvector`
+ *
+ * `CSA` uses the default bitvector. A sparse bitvector (e.g. BasicCSA<EliasFanoBitvector<>>)
+ * reduces the space of the marks, but each value() becomes slower. push_back() requires a bitvector that supports push_back,
+ * CSAs over other bitvectors can not be appended to or merged.
+ */
+template <Bitvector_c TBitvector = bitvector::Bitvector2L<512, 65536>>
+struct BasicCSA {
+    using Bitvector = TBitvector;
+    mmser::vector<uint64_t> ssa; // mmser::vector enables mmap when being loaded from disk
     Bitvector             bv;
     size_t                bitsForPosition{};   // bits reserved for position
     uint64_t              bitPositionMask{};   // Bit mask, to extract the position from ssa
     size_t                seqCount{};          // Number of sequences
 
 
-    static auto createJoinedCSA(CSA const& lhs, CSA const& rhs) -> CSA {
-        auto csa = CSA{};
+    static auto createJoinedCSA(BasicCSA const& lhs, BasicCSA const& rhs) -> BasicCSA {
+        auto csa = BasicCSA{};
         size_t bitsForPosition = std::max(lhs.bitsForPosition, rhs.bitsForPosition);
         auto seqBits = size_t(std::ceil(std::log2(lhs.seqCount + rhs.seqCount)));
         if (seqBits + bitsForPosition > 64) {
@@ -59,15 +70,15 @@ struct CSA {
     }
 
 
-    CSA() = default;
-    CSA(CSA const&) = delete;
-    CSA(CSA&&) noexcept = default;
+    BasicCSA() = default;
+    BasicCSA(BasicCSA const&) = delete;
+    BasicCSA(BasicCSA&&) noexcept = default;
 
     template <std::ranges::range Range>
         requires requires(Range r) {
             {*(r.begin())} -> std::same_as<std::optional<std::tuple<size_t, size_t>>>;
         }
-    CSA(Range _ssa, size_t sequencesCount, size_t longestSequence)
+    BasicCSA(Range _ssa, size_t sequencesCount, size_t longestSequence)
         : seqCount{sequencesCount}
     {
         bitsForPosition = size_t(std::ceil(std::log2(longestSequence)));
@@ -77,23 +88,31 @@ struct CSA {
         }
         bitPositionMask = (uint64_t{1}<<bitsForPosition)-1;
 
+        auto marks = std::vector<uint8_t>{};
         for (auto o : _ssa) {
-            push_back(o);
+            marks.push_back(o.has_value());
+            if (o) {
+                auto [seqNr, pos] = *o;
+                ssa.push_back((seqNr << bitsForPosition) + pos);
+            }
         }
+        bv = Bitvector{marks};
     }
 
     template <std::ranges::sized_range range_t>
         requires std::convertible_to<std::ranges::range_value_t<range_t>, uint8_t>
-    CSA(std::vector<uint64_t> _ssa, range_t const& bitstack, size_t _bitsForPosition, size_t _seqCount)
-        : ssa{std::move(_ssa)}
-        , bv{bitstack}
+    BasicCSA(std::vector<uint64_t> const& _ssa, range_t const& bitstack, size_t _bitsForPosition, size_t _seqCount)
+        : bv{bitstack}
         , bitsForPosition{_bitsForPosition}
         , bitPositionMask{(uint64_t{1}<<bitsForPosition)-1}
         , seqCount{_seqCount}
-    {}
+    {
+        ssa.resize(_ssa.size());
+        std::ranges::copy(_ssa, ssa.begin());
+    }
 
     template <typename T>
-    CSA(std::vector<T> const& sa, size_t samplingRate, std::span<size_t const> _inputSizes, bool reverse=false, size_t seqOffset=0)
+    BasicCSA(std::vector<T> const& sa, size_t samplingRate, std::span<size_t const> _inputSizes, bool reverse=false, size_t seqOffset=0)
         : seqCount{_inputSizes.size()}
     {
         assert(samplingRate != 0);
@@ -109,7 +128,7 @@ struct CSA {
 
 
         // create a sampling in text space
-        auto textAnnotationValid = Bitvector{};
+        auto textAnnotationValid = bitvector::Bitvector2L<512, 65536>{};
         auto textAnnotation = std::vector<uint64_t>{};
         for (size_t refId{0}; refId < _inputSizes.size(); ++refId) {
             for (size_t posId{0}; posId < _inputSizes[refId]; ++posId) {
@@ -125,21 +144,32 @@ struct CSA {
             }
         }
         // converts text space into sampled suffix array space
-        std::tie(bv, ssa) = suffixarray::createSampling(sa, textAnnotationValid, textAnnotation);
+        std::tie(bv, ssa) = suffixarray::createSampling<Bitvector>(sa, textAnnotationValid, textAnnotation);
     }
 
-    auto operator=(CSA const&) -> CSA& = delete;
-    auto operator=(CSA&&) noexcept -> CSA& = default;
+    auto operator=(BasicCSA const&) -> BasicCSA& = delete;
+    auto operator=(BasicCSA&&) noexcept -> BasicCSA& = default;
 
     size_t memoryUsage() const {
         return sizeof(ssa) + ssa.size() * sizeof(ssa.back());
     }
 
     auto value(size_t idx) const -> std::optional<std::tuple<uint64_t, uint64_t>> {
-        if (!bv.symbol(idx)) {
-            return std::nullopt;
+        size_t r{};
+        // bitvectors that locate symbol and rank in the same step (e.g. EliasFanoBitvector)
+        if constexpr (requires() { bv.rankAndSymbol(idx); }) {
+            auto [rank, symb] = bv.rankAndSymbol(idx);
+            if (!symb) {
+                return std::nullopt;
+            }
+            r = rank;
+        } else {
+            if (!bv.symbol(idx)) {
+                return std::nullopt;
+            }
+            r = bv.rank(idx);
         }
-        auto v = ssa[bv.rank(idx)];
+        auto v = ssa[r];
         auto chr = v >> bitsForPosition;
         auto pos = v & bitPositionMask;
 
@@ -147,6 +177,7 @@ struct CSA {
     }
 
     void push_back(std::optional<std::tuple<size_t, size_t>> value) {
+        static_assert(requires(Bitvector& b) { b.push_back(true); }, "CSA::push_back requires a bitvector with push_back");
         bv.push_back(value.has_value());
         if (value) {
             auto [seqNr, pos] = *value;
@@ -159,6 +190,8 @@ struct CSA {
         ar(self.ssa, self.bv, self.bitsForPosition, self.bitPositionMask, self.seqCount);
     }
 };
+using CSA = BasicCSA<>;
+
 static_assert(SuffixArray_c<CSA>);
 
 }
@@ -62,6 +62,14 @@ struct SparseArray {
 
     auto value(size_t idx) const -> std::optional<Entry> {
         assert(idx < bv.size());
+        // bitvectors that locate symbol and rank in the same step (e.g. EliasFanoBitvector)
+        if constexpr (requires() { bv.rankAndSymbol(idx); }) {
+            auto [r, v] = bv.rankAndSymbol(idx);
+            if (!v) {
+                return std::nullopt;
+            }
+            return documents[r];
+        }
         if (!bv.symbol(idx)) {
             return std::nullopt;
         }
@@ -69,6 +77,13 @@ struct SparseArray {
         return documents[r];
     }
 
+    // requests the memory of the bitvector accessed by value(idx)
+    void prefetch(size_t idx) const {
+        if constexpr (requires() { bv.prefetch(idx); }) {
+            bv.prefetch(idx);
+        }
+    }
+
     template <typename Archive>
     void serialize(this auto&& self, Archive& ar) {
         ar(self.documents, self.bv);
@@ -6,10 +6,12 @@
 #include "bitset_popcount.h"
 #include "std/chunk_view.hpp"
 #include "concepts.h"
+#include "parallel.h"
 #include "string/concepts.h"
 #include "VectorBool.h"
 
 #include <algorithm>
+#include <bit>
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -18,6 +20,7 @@
 #include <mmser/mmser.h>
 #include <numeric>
 #include <optional>
+#include <ranges>
 #include <span>
 #include <stdexcept>
 #include <tuple>
@@ -142,31 +145,35 @@ auto createSA(std::span<uint8_t const> input, size_t threadNbr) -> std::vector<T
 }
 
 
-inline auto createBWT64(std::span<uint8_t const> input, std::span<uint64_t const> sa) -> std::vector<uint8_t> {
+inline auto createBWT64(std::span<uint8_t const> input, std::span<uint64_t const> sa, size_t threadNbr = 1) -> std::vector<uint8_t> {
     assert(input.size() == sa.size());
     auto bwt = std::vector<uint8_t>{};
     bwt.resize(input.size());
-    for (size_t i{0}; i < sa.size(); ++i) {
-        bwt[i] = input[(sa[i] + input.size() - 1) % input.size()];
-    }
+    parallelFor(sa.size(), threadNbr, /*.chunkSize=*/1ull<<20, [&](size_t begin, size_t end) {
+        for (size_t i{begin}; i < end; ++i) {
+            bwt[i] = input[(sa[i] + input.size() - 1) % input.size()];
+        }
+    });
     return bwt;
 }
 
-inline auto createBWT32(std::span<uint8_t const> input, std::span<uint32_t const> sa) -> std::vector<uint8_t> {
+inline auto createBWT32(std::span<uint8_t const> input, std::span<uint32_t const> sa, size_t threadNbr = 1) -> std::vector<uint8_t> {
     assert(input.size() == sa.size());
     auto bwt = std::vector<uint8_t>{};
     bwt.resize(input.size());
-    for (size_t i{0}; i < sa.size(); ++i) {
-        bwt[i] = input[(sa[i] + input.size() - 1) % input.size()];
-    }
+    parallelFor(sa.size(), threadNbr, /*.chunkSize=*/1ull<<20, [&](size_t begin, size_t end) {
+        for (size_t i{begin}; i < end; ++i) {
+            bwt[i] = input[(sa[i] + input.size() - 1) % input.size()];
+        }
+    });
     return bwt;
 }
 template <typename T>
-auto createBWT(std::span<uint8_t const> input, std::span<T const> sa) -> std::vector<uint8_t> {
+auto createBWT(std::span<uint8_t const> input, std::span<T const> sa, size_t threadNbr = 1) -> std::vector<uint8_t> {
     if constexpr (std::same_as<T, uint64_t>) {
-        return createBWT64(input, sa);
+        return createBWT64(input, sa, threadNbr);
     } else if constexpr (std::same_as<T, uint32_t>) {
-        return createBWT32(input, sa);
+        return createBWT32(input, sa, threadNbr);
     } else {
         []<bool b = false>() {
             static_assert(b, "Must be of type uint64_t or uint32_t");
@@ -217,6 +224,84 @@ auto computeCSpan(std::span<uint8_t const> s) -> std::array<size_t, Sigma+1> {
     return res;
 }
 
+/** Creates a SparseArray with `_size` entries from a compact representation
+ *
+ * \param _words   bit `i%64` of `_words[i/64]` indicates if entry `i` has a value
+ * \param _entries the values of all entries that have one, in order
+ */
+template <typename SparseArray, typename Entry>
+auto createSparseArray(size_t _size, std::vector<uint64_t> const& _words, std::vector<Entry> const& _entries) -> SparseArray {
+    // number of entries before each word
+    auto wordRanks = std::vector<uint64_t>(_words.size()+1);
+    for (size_t w{0}; w < _words.size(); ++w) {
+        wordRanks[w+1] = wordRanks[w] + std::popcount(_words[w]);
+    }
+
+    return SparseArray {std::views::iota(size_t{0}, _size) | std::views::transform([&](size_t i) -> std::optional<Entry> {
+        auto word = _words[i / 64];
+        auto mask = uint64_t{1} << (i % 64);
+        if (!(word & mask)) {
+            return std::nullopt;
+        }
+        return _entries[wordRanks[i / 64] + std::popcount(word & (mask - 1))];
+    })};
+}
+
+/** Creates a SparseArray with `_size` entries, entry `i` is `_valueAt(i)`
+ *
+ * `_valueAt` is evaluated on `_threadNbr` threads. The results are gathered into
+ * one bit per entry plus the list of found values, from which the SparseArray is
+ * constructed in a single cheap pass.
+ */
+template <typename SparseArray, typename valueAt_t>
+auto createSparseArray(size_t _size, valueAt_t const& _valueAt, size_t _threadNbr) -> SparseArray {
+    using Entry = typename decltype(_valueAt(size_t{}))::value_type;
+
+    auto const wordCt = (_size + 63) / 64;
+    auto words   = std::vector<uint64_t>(wordCt);
+    auto entries = std::vector<Entry>{};
+    parallelBatch<Entry>(wordCt, _threadNbr, /*.chunkSize=*/1ull<<14, [&](size_t begin, size_t end, std::vector<Entry>& buffer) {
+        for (size_t w{begin}; w < end; ++w) {
+            auto word = uint64_t{};
+            for (size_t i{w*64}; i < std::min(w*64+64, _size); ++i) {
+                if (auto v = _valueAt(i); v) {
+                    word |= uint64_t{1} << (i % 64);
+                    buffer.push_back(*v);
+                }
+            }
+            words[w] = word;
+        }
+    }, [&](std::vector<Entry> const& buffer) {
+        entries.insert(entries.end(), buffer.begin(), buffer.end());
+    });
+
+    return createSparseArray<SparseArray>(_size, words, entries);
+}
+
+/** Creates the sampled suffix array, entry `i` is `_annotatedSequence.value(sa[i])`
+ *
+ * The lookups into `_annotatedSequence` are random accesses and run on `_threadNbr` threads.
+ */
+template <typename SparseArray, typename T>
+auto createAnnotatedArray(std::span<T const> sa, SparseArray const& _annotatedSequence, size_t _threadNbr) -> SparseArray {
+    return createSparseArray<SparseArray>(sa.size(), [&](size_t i) {
+        return _annotatedSequence.value(sa[i]);
+    }, _threadNbr);
+}
+
+/** Creates a string with rank support
+ *
+ * Strings offering a `(symbols, threadNbr)` constructor are build on multiple threads.
+ */
+template <typename String>
+auto createString(std::span<uint8_t const> _symbols, size_t _threadNbr) -> String {
+    if constexpr (std::constructible_from<String, std::span<uint8_t const>, size_t>) {
+        return String{_symbols, _threadNbr};
+    } else {
+        return String{_symbols};
+    }
+}
+
 template <typename SparseArray>
 auto createBWTAndAnnotatedArray(std::span<uint8_t const> inputText, SparseArray const& _annotatedSequence, size_t _threadNbr, bool _omegaSorting) {
     auto f = [&]<typename word_t>() {
@@ -232,11 +317,8 @@ auto createBWTAndAnnotatedArray(std::span<uint8_t const> inputText, SparseArray
             inputText = {inputText.begin(), inputText.begin() + inputText.size()/2};
         }
 
-        auto bwt = createBWT<word_t>(inputText, sa);
-        auto cb = [&](size_t i) {
-            return _annotatedSequence.value(i);
-        };
-        auto annotatedArray = SparseArray {sa | std::views::transform(cb)};
+        auto bwt = createBWT<word_t>(inputText, sa, _threadNbr);
+        auto annotatedArray = createAnnotatedArray<SparseArray, word_t>(sa, _annotatedSequence, _threadNbr);
         return std::make_tuple(std::move(bwt), std::move(annotatedArray));
     };
 
@@ -300,7 +382,7 @@ inline auto createBWT(std::span<uint8_t const> inputText, size_t _threadNbr, boo
             inputText = {inputText.begin(), inputText.begin() + inputText.size()/2};
         }
 
-        auto bwt = createBWT<word_t>(inputText, sa);
+        auto bwt = createBWT<word_t>(inputText, sa, _threadNbr);
         return bwt;
     };
 
@@ -717,6 +799,48 @@ inline auto createInputData(std::vector<std::string> args) -> std::vector<std::v
     }
     return ret;
 }
+
+/**
+ * unittest helper function, random sequences of the given lengths over the symbols 1.._symbols
+ */
+template <typename Rng>
+auto generateText(Rng& _rng, std::vector<size_t> const& _lengths, size_t _symbols = 4) -> std::vector<std::vector<uint8_t>> {
+    auto ret = std::vector<std::vector<uint8_t>>{};
+    for (auto len : _lengths) {
+        auto& seq = ret.emplace_back();
+        for (size_t i{0}; i < len; ++i) {
+            seq.push_back(static_cast<uint8_t>(1 + _rng() % _symbols));
+        }
+    }
+    return ret;
+}
+
+/**
+ * unittest helper function, `_count` random substrings of `_texts` with up to `_maxSubstitutions` random substitutions
+ *
+ * The i-th query has length `_lengths[i % _lengths.size()]` and is taken from a sequence that is longer than that.
+ * Throws if no sequence is long enough.
+ */
+template <typename Rng>
+auto sampleQueries(Rng& _rng, std::vector<std::vector<uint8_t>> const& _texts, size_t _count, std::vector<size_t> const& _lengths, size_t _maxSubstitutions, size_t _symbols = 4) -> std::vector<std::vector<uint8_t>> {
+    auto ret = std::vector<std::vector<uint8_t>>{};
+    for (size_t i{0}; i < _count; ++i) {
+        auto len = _lengths[i % _lengths.size()];
+        if (std::ranges::none_of(_texts, [&](auto const& t) { return t.size() > len; })) {
+            throw std::runtime_error{"sampleQueries: no text is longer than the requested query length"};
+        }
+        auto seq = &_texts[_rng() % _texts.size()];
+        while (seq->size() <= len) {
+            seq = &_texts[_rng() % _texts.size()];
+        }
+        auto pos    = _rng() % (seq->size() - len);
+        auto& query = ret.emplace_back(seq->begin() + pos, seq->begin() + pos + len);
+        for (size_t j{0}, n = _rng() % (_maxSubstitutions + 1); j < n && len > 0; ++j) {
+            query[_rng() % len] = static_cast<uint8_t>(1 + _rng() % _symbols);
+        }
+    }
+    return ret;
+}
 }
 
 }
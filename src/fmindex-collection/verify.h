@@ -0,0 +1,236 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: BSD-3-Clause
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace fmc {
+
+/**
+ * Result of a verification
+ *
+ * `transcript` lists the edit operations from the first to the last query symbol,
+ * using the same letters as the search engines:
+ *  - 'M': match
+ *  - 'S': substitution
+ *  - 'I': insertion, the query has a symbol that is missing in the text
+ *  - 'D': deletion, the text has a symbol that is missing in the query
+ */
+struct Alignment {
+    size_t      begin{};  // first aligned text position
+    size_t      end{};    // one past the last aligned text position
+    size_t      errors{}; // edit distance
+    std::string transcript;
+};
+
+/**
+ * Bit-parallel edit distance verifier (Myers 1999)
+ *
+ * Queries longer than 64 symbols are split into 64bit blocks, the horizontal
+ * delta is carried from block to block (Hyyrö 2003). Processing a text symbol
+ * costs O(ceil(|query|/64)) word operations.
+ *
+ * Two modes are supported:
+ *  - free:     the alignment may start anywhere inside the text (approximate string matching)
+ *  - anchored: the alignment starts at the first text symbol
+ * In both modes the complete query is aligned and the end inside the text is free.
+ */
+struct MyersVerifier {
+    size_t                m{};     // length of the query
+    size_t                words{}; // number of 64bit blocks
+    std::vector<uint8_t>  query;
+    std::vector<uint64_t> peq;     // peq[symb * words + w]: positions of `symb` inside block `w`
+
+    MyersVerifier() = default;
+    MyersVerifier(std::span<uint8_t const> _query)
+        : m{_query.size()}
+        , words{(_query.size() + 63) / 64}
+        , query(_query.begin(), _query.end())
+        , peq(256 * words, 0)
+    {
+        for (size_t i{0}; i < m; ++i) {
+            peq[size_t{_query[i]} * words + i / 64] |= uint64_t{1} << (i % 64);
+        }
+    }
+
+    /**
+     * Reports every end position `e` of `_text` (0 ≤ e ≤ |_text|) at which an alignment with at most `_maxErrors` errors ends
+     *
+     * \param _cb callback, called with (size_t end, size_t errors) in ascending order of `end`
+     */
+    template <typename CB>
+    void findAll(std::span<uint8_t const> _text, size_t _maxErrors, bool _anchored, CB const& _cb) const {
+        run(_text, _anchored, nullptr, [&](size_t end, size_t errors) {
+            if (errors <= _maxErrors) {
+                _cb(end, errors);
+            }
+        });
+    }
+
+    /**
+     * Best end position
+     *
+     * Ties are broken in favor of the end position that results in a text length closest to the query length.
+     * \return (end, errors) or std::nullopt if no alignment with at most `_maxErrors` errors exists
+     */
+    auto findBest(std::span<uint8_t const> _text, size_t _maxErrors, bool _anchored) const -> std::optional<std::tuple<size_t, size_t>> {
+        auto best = std::optional<std::tuple<size_t, size_t>>{};
+        // text length of an alignment ending at `end`, only exact for anchored alignments
+        auto dist = [&](size_t end) { return end > m ? end - m : m - end; };
+        findAll(_text, _maxErrors, _anchored, [&](size_t end, size_t errors) {
+            if (!best) {
+                best = {end, errors};
+                return;
+            }
+            auto [bestEnd, bestErrors] = *best;
+            if (errors < bestErrors || (errors == bestErrors && _anchored && dist(end) < dist(bestEnd))) {
+                best = {end, errors};
+            }
+        });
+        return best;
+    }
+
+    /**
+     * Best alignment including its traceback
+     *
+     * \return alignment or std::nullopt if no alignment with at most `_maxErrors` errors exists
+     */
+    auto align(std::span<uint8_t const> _text, size_t _maxErrors, bool _anchored = false) const -> std::optional<Alignment> {
+        auto best = findBest(_text, _maxErrors, _anchored);
+        if (!best) return std::nullopt;
+        auto [end, errors] = *best;
+
+        // rerun up to the end position, storing the vertical deltas of every column
+        auto columns = std::vector<uint64_t>{};
+        columns.reserve(end * words * 2);
+        run(_text.subspan(0, end), _anchored, &columns, [](size_t, size_t) {});
+
+        // D[i][j] = D[0][j] + sum of the vertical deltas of the first i rows of column j
+        auto score = [&](size_t i, size_t j) -> size_t {
+            if (j == 0) return i;
+            auto const* pv = columns.data() + (j-1) * words * 2;
+            auto const* mv = pv + words;
+            int64_t s = _anchored ? j : 0;
+            for (size_t w{0}; w*64 < i; ++w) {
+                auto mask = (i - w*64 >= 64) ? ~uint64_t{0} : ((uint64_t{1} << (i - w*64)) - 1);
+                s += std::popcount(pv[w] & mask);
+                s -= std::popcount(mv[w] & mask);
+            }
+            return static_cast<size_t>(s);
+        };
+
+        auto res = Alignment{.begin = 0, .end = end, .errors = errors, .transcript = {}};
+        size_t i = m;
+        size_t j = end;
+        while (i > 0) {
+            auto s = score(i, j);
+            if (j > 0) {
+                bool match = query[i-1] == _text[j-1];
+                if (score(i-1, j-1) + (match ? 0 : 1) == s) {
+                    res.transcript.push_back(match ? 'M' : 'S');
+                    i -= 1;
+                    j -= 1;
+                    continue;
+                }
+            }
+            if (score(i-1, j) + 1 == s) {
+                res.transcript.push_back('I');
+                i -= 1;
+                continue;
+            }
+            res.transcript.push_back('D');
+            j -= 1;
+        }
+        // anchored alignments always start at the beginning of the text
+        if (_anchored) {
+            res.transcript.append(j, 'D');
+            j = 0;
+        }
+        res.begin = j;
+        std::ranges::reverse(res.transcript);
+        return res;
+    }
+
+private:
+    /* computes one column of a 64bit block
+     *
+     * \param _hin horizontal delta entering the block from above (-1, 0, +1)
+     * \param _highBit bit of the last row inside this block
+     * \return horizontal delta leaving the block at the bottom
+     */
+    static int advanceBlock(uint64_t& _pv, uint64_t& _mv, uint64_t _eq, int _hin, uint64_t _highBit) {
+        uint64_t xv = _eq | _mv;
+        if (_hin < 0) _eq |= 1;
+        uint64_t xh = (((_eq & _pv) + _pv) ^ _pv) | _eq;
+        uint64_t ph = _mv | ~(xh | _pv);
+        uint64_t mh = _pv & xh;
+        int hout = 0;
+        if (ph & _highBit) hout = 1;
+        if (mh & _highBit) hout = -1;
+        ph <<= 1;
+        mh <<= 1;
+        if (_hin < 0) mh |= 1;
+        if (_hin > 0) ph |= 1;
+        _pv = mh | ~(xv | ph);
+        _mv = ph & xv;
+        return hout;
+    }
+
+    //!\brief computes the score of every end position, optionally storing all columns
+    template <typename CB>
+    void run(std::span<uint8_t const> _text, bool _anchored, std::vector<uint64_t>* _columns, CB const& _cb) const {
+        auto pv = std::vector<uint64_t>(words, ~uint64_t{0});
+        auto mv = std::vector<uint64_t>(words, 0);
+        auto lastBit = uint64_t{1} << ((m + 63) % 64);
+
+        size_t score = m;
+        _cb(0, score);
+        for (size_t j{0}; j < _text.size(); ++j) {
+            auto const* eq = peq.data() + size_t{_text[j]} * words;
+            int hin = _anchored ? 1 : 0; // row 0 is D[0][j] = j (anchored) or 0 (free)
+            for (size_t w{0}; w < words; ++w) {
+                hin = advanceBlock(pv[w], mv[w], eq[w], hin, (w+1 == words) ? lastBit : (uint64_t{1} << 63));
+            }
+            score = static_cast<size_t>(static_cast<int64_t>(score) + hin);
+            if (_columns) {
+                _columns->insert(_columns->end(), pv.begin(), pv.end());
+                _columns->insert(_columns->end(), mv.begin(), mv.end());
+            }
+            _cb(j+1, score);
+        }
+    }
+};
+
+/**
+ * Verifies a located hit directly inside the text and computes its alignment
+ *
+ * Can be used as final stage of any search, e.g. on the results reported by `fmc::Search`.
+ * The text around `_pos` is extracted via the sampled inverse suffix array of the index (`index.isa`).
+ *
+ * \param _pos       text position of the hit, as reported by locate
+ * \param _maxErrors maximum number of errors, also the slack that is added to both sides of the text window
+ * \return alignment with `begin` and `end` in coordinates of sequence `_seqId` or std::nullopt if the hit could not be confirmed
+ */
+template <typename Index>
+auto verifyHit(Index const& _index, MyersVerifier const& _verifier, size_t _seqId, size_t _pos, size_t _maxErrors) -> std::optional<Alignment> {
+    auto seqLen = _index.isa.length(_seqId);
+    auto begin  = _pos > _maxErrors ? _pos - _maxErrors : size_t{0};
+    auto end    = std::min(seqLen, _pos + _verifier.m + _maxErrors);
+    begin       = std::min(begin, end);
+    auto text   = _index.extract(_seqId, begin, end);
+    auto res    = _verifier.align(text, _maxErrors);
+    if (!res) return std::nullopt;
+    res->begin += begin;
+    res->end   += begin;
+    return res;
+}
+
+}
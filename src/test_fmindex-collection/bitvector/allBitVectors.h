@@ -75,4 +75,5 @@
     fmc::bitvector::SparseRBBitvector<4, fmc::bitvector::Bitvector1L_64, fmc::bitvector::Bitvector2L_512_64k>, \
     fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_64_64k, fmc::bitvector::Bitvector1L_64>, \
     fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_512_64k, fmc::bitvector::Bitvector1L_64>, \
-    fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_512_64k, fmc::bitvector::Bitvector2L_512_64k>
+    fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_512_64k, fmc::bitvector::Bitvector2L_512_64k>, \
+    fmc::bitvector::EliasFanoBitvector<>
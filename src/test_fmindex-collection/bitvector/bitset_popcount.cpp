@@ -4,7 +4,9 @@
 #include <catch2/catch_all.hpp>
 #include <fmindex-collection/bitset_popcount.h>
 
+#include <array>
 #include <fstream>
+#include <random>
 #include <nanobench.h>
 
 TEST_CASE("check if signed_rshift_and_count works", "[signed_rshift_and_count]") {
@@ -57,6 +59,50 @@ TEST_CASE("count_first_or_last_n_bits", "[count_bits]") {
     }
 }
 
+TEST_CASE("check rank kernels against the scalar implementation", "[rank_kernels]") {
+    using namespace fmc::rank_kernels;
+    auto rng = std::mt19937_64{};
+    auto test = [&]<size_t Words>() {
+        auto data = std::array<std::array<uint64_t, Words>, 4>{};
+        for (auto& a : data) {
+            for (auto& w : a) {
+                w = rng();
+            }
+        }
+        auto const& [l, r, bits, mask] = data;
+        auto expectedOut   = std::array<uint64_t, Words>{};
+        auto expectedAnd   = andCountScalar(l.data(), mask.data(), Words);
+        auto expectedOrAnd = orAndNotCountScalar(l.data(), r.data(), bits.data(), mask.data(), expectedOut.data(), Words);
+
+        for (auto k : {Kernel::Popcnt, Kernel::AVX2, Kernel::AVX512BW, Kernel::AVX512VPOPCNTDQ}) {
+            if (!isSupported(k)) continue;
+            INFO("kernel " << static_cast<int>(k) << ", words " << Words);
+            CHECK(selectAndCount(k)(l.data(), mask.data(), Words) == expectedAnd);
+            auto out = std::array<uint64_t, Words>{};
+            CHECK(selectOrAndNotCount(k)(l.data(), r.data(), bits.data(), mask.data(), out.data(), Words) == expectedOrAnd);
+            CHECK(out == expectedOut);
+        }
+    };
+    for (size_t i{0}; i < 100; ++i) {
+        test.template operator()<4>();
+        test.template operator()<8>();
+        test.template operator()<16>();
+    }
+
+    SECTION("bitset wrappers") {
+        auto b    = std::bitset<512>{};
+        auto mask = std::bitset<512>{};
+        for (size_t i{0}; i < 512; ++i) {
+            b[i]    = rng() % 2;
+            mask[i] = i < 300;
+        }
+        CHECK(andCount(b, mask) == (b & mask).count());
+        auto [out, count] = orAndNotCount(b, mask, ~b, mask);
+        CHECK(out == (b | (mask & b)));
+        CHECK(count == (out & mask).count());
+    }
+}
+
 TEST_CASE("benchmark skip_first_or_last_n_bits", "[misc][!benchmark]") {
     auto rng = ankerl::nanobench::Rng{};
 
@@ -17,6 +17,7 @@ using AllTypes = std::variant<
     fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_512_64k, fmc::bitvector::Bitvector2L_512_64k>,
     fmc::bitvector::OptRBBitvector<fmc::bitvector::Bitvector2L_64_64k, fmc::bitvector::Bitvector2L_64_64k>,
     fmc::bitvector::OptSparseRBBitvector<fmc::bitvector::Bitvector2L_64_64k, fmc::bitvector::Bitvector2L_64_64k>,
+    fmc::bitvector::EliasFanoBitvector<>,
 #if defined(FMC_USE_RANKSELECT)
     RankSelect<5>,
 #endif
@@ -243,3 +244,49 @@ TEST_CASE("benchmark bit vectors memory consumption - with blocks", "[sparse-bit
         }
     }
 }
+
+TEST_CASE("benchmark bit vectors as suffix array sample marks", "[sparse-bitvector][!benchmark][sampling]") {
+    // marks every `rate`-th row on average, as the sampled suffix array of an index does
+    for (size_t rate : {8, 16, 32, 64}) {
+        auto text = generateText(1. / rate);
+
+        BenchSize benchSize;
+        benchSize.baseSize = 1.;
+
+        auto bench_value = ankerl::nanobench::Bench{};
+        bench_value.title("symbol() + rank() sampling rate:" + std::to_string(rate))
+                   .relative(true);
+        bench_value.epochs(20);
+        bench_value.minEpochTime(std::chrono::milliseconds{1});
+        bench_value.minEpochIterations(1'000'000);
+
+        call_with_templates<AllTypes>([&]<typename Vector>() {
+            auto vector_name = getName<Vector>();
+            INFO(vector_name);
+
+            auto rng = ankerl::nanobench::Rng{};
+            auto vec = Vector{text};
+
+            // same access pattern as SparseArray::value()
+            bench_value.run(vector_name, [&]() {
+                auto idx = rng.bounded(text.size());
+                uint64_t v{};
+                if (vec.symbol(idx)) {
+                    v = vec.rank(idx);
+                }
+                ankerl::nanobench::doNotOptimizeAway(v);
+            });
+
+            auto ofs     = std::stringstream{};
+            auto archive = cereal::BinaryOutputArchive{ofs};
+            archive(vec);
+            auto s = ofs.str().size();
+            benchSize.addEntry({
+                .name = vector_name + " sampling rate " + std::to_string(rate),
+                .size = s,
+                .text_size = text.size(),
+                .bits_per_char = (s*8)/double(text.size())
+            });
+        });
+    }
+}
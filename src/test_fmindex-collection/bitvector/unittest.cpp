@@ -3,8 +3,12 @@
 // SPDX-License-Identifier: CC0-1.0
 #include <catch2/catch_all.hpp>
 #include <cstdlib>
+#include <fmindex-collection/suffixarray/SparseArray.h>
 #include <fmindex-collection/utils.h>
 #include <fstream>
+#include <optional>
+#include <random>
+#include <tuple>
 
 #include "../string/utils.h"
 #include "allBitVectors.h"
@@ -418,3 +422,70 @@ TEST_CASE("check bit vectors are working", "[bitvector]") {
         });
     }
 }
+
+TEST_CASE("check elias fano bit vector", "[bitvector][eliasfano]") {
+    using Vector = fmc::bitvector::EliasFanoBitvector<4>; // small sample rate, so buckets are skipped and sampled
+
+    auto check = [](std::vector<uint8_t> const& text) {
+        auto vec = Vector{text};
+        auto vecDefault = fmc::bitvector::EliasFanoBitvector<>{text};
+        REQUIRE(vec.size() == text.size());
+        size_t count{};
+        for (size_t i{0}; i < text.size(); ++i) {
+            INFO(i);
+            CHECK(vec.symbol(i) == (bool)text[i]);
+            CHECK(vec.rank(i) == count);
+            CHECK(vecDefault.rankAndSymbol(i) == std::tuple<uint64_t, bool>{count, (bool)text[i]});
+            count += text[i];
+        }
+        CHECK(vec.rank(text.size()) == count);
+        CHECK(vecDefault.rank(text.size()) == count);
+    };
+
+    SECTION("edge cases") {
+        check({});
+        check({0});
+        check({1});
+        check({0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+        check({1, 1, 1, 1, 1, 1, 1, 1, 1, 1});
+        check({1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1});
+    }
+
+    SECTION("random texts of different densities") {
+        auto rng = std::mt19937_64{};
+        for (size_t rate : {1, 2, 3, 16, 32, 1000}) {
+            INFO(rate);
+            auto text = std::vector<uint8_t>{};
+            for (size_t i{0}; i < 5'000; ++i) {
+                text.push_back(rng() % rate == 0);
+            }
+            check(text);
+        }
+    }
+
+    SECTION("more compact than Bitvector2L for sparse marks") {
+        auto text = std::vector<uint8_t>(100'000, 0);
+        for (size_t i{0}; i < text.size(); i += 16) {
+            text[i] = 1;
+        }
+        auto ef = fmc::bitvector::EliasFanoBitvector<>{text};
+        CHECK(ef.space_usage() * 2 < fmc::bitvector::Bitvector2L<512, 65536>::estimateSize(text.size()) / 8);
+    }
+
+    SECTION("usable as bitvector of a SparseArray") {
+        auto rng    = std::mt19937_64{};
+        auto values = std::vector<std::optional<std::tuple<uint32_t, uint32_t>>>{};
+        for (size_t i{0}; i < 10'000; ++i) {
+            if (rng() % 16 == 0) {
+                values.emplace_back(std::tuple<uint32_t, uint32_t>{rng() % 7, i});
+            } else {
+                values.emplace_back(std::nullopt);
+            }
+        }
+        auto array = fmc::suffixarray::SparseArray<std::tuple<uint32_t, uint32_t>, fmc::bitvector::EliasFanoBitvector<>>{values};
+        for (size_t i{0}; i < values.size(); ++i) {
+            INFO(i);
+            CHECK(array.value(i) == values[i]);
+        }
+    }
+}
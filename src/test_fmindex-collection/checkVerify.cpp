@@ -0,0 +1,134 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: CC0-1.0
+
+#include <catch2/catch_all.hpp>
+#include <fmindex-collection/fmindex/BiFMIndex.h>
+#include <fmindex-collection/verify.h>
+#include <random>
+
+namespace {
+// last row of the dp matrix, D[m][j] for all j
+auto naiveLastRow(std::vector<uint8_t> const& query, std::vector<uint8_t> const& text, bool anchored) {
+    auto row = std::vector<size_t>(text.size()+1);
+    for (size_t j{0}; j < row.size(); ++j) {
+        row[j] = anchored ? j : 0;
+    }
+    for (size_t i{1}; i <= query.size(); ++i) {
+        size_t diag = row[0];
+        row[0] = i;
+        for (size_t j{1}; j < row.size(); ++j) {
+            auto v = std::min({diag + (query[i-1] != text[j-1]), row[j] + 1, row[j-1] + 1});
+            diag   = row[j];
+            row[j] = v;
+        }
+    }
+    return row;
+}
+
+// applies the transcript to the query, returns the aligned text and the number of errors
+auto applyTranscript(std::vector<uint8_t> const& query, std::vector<uint8_t> const& text, fmc::Alignment const& alignment) {
+    auto aligned = std::vector<uint8_t>{};
+    size_t errors{};
+    size_t i{0}, j{alignment.begin};
+    for (auto c : alignment.transcript) {
+        if (c == 'M') {
+            CHECK(query[i] == text[j]);
+            aligned.push_back(query[i++]);
+            j += 1;
+        } else if (c == 'S') {
+            CHECK(query[i] != text[j]);
+            aligned.push_back(text[j++]);
+            i += 1;
+            errors += 1;
+        } else if (c == 'I') {
+            i += 1;
+            errors += 1;
+        } else if (c == 'D') {
+            aligned.push_back(text[j++]);
+            errors += 1;
+        }
+    }
+    CHECK(i == query.size());
+    CHECK(j == alignment.end);
+    return std::make_tuple(aligned, errors);
+}
+}
+
+TEST_CASE("checking bit-parallel verifier", "[verify]") {
+    auto rng = std::mt19937{3};
+    auto randomSeq = [&](size_t len) {
+        return fmc::test::generateText(rng, {len})[0];
+    };
+
+    for (size_t len : {0, 1, 10, 63, 64, 65, 128, 150}) {
+        for (size_t rep{0}; rep < 5; ++rep) {
+            auto text  = randomSeq(len + 40);
+            auto query = std::vector<uint8_t>(text.begin() + 20, text.begin() + 20 + len);
+            for (size_t e{0}, n = rng() % 4; e < n && !query.empty(); ++e) {
+                auto p = rng() % query.size();
+                switch (rng() % 3) {
+                    case 0: query[p] = 1 + rng() % 4; break;
+                    case 1: query.erase(query.begin() + p); break;
+                    case 2: query.insert(query.begin() + p, 1 + rng() % 4); break;
+                }
+            }
+            auto verifier = fmc::MyersVerifier{query};
+
+            for (bool anchored : {false, true}) {
+                INFO(len << " " << rep << " " << anchored);
+                auto expected = naiveLastRow(query, text, anchored);
+
+                // all scores
+                auto scores = std::vector<size_t>{};
+                verifier.findAll(text, std::numeric_limits<size_t>::max(), anchored, [&](size_t end, size_t errors) {
+                    CHECK(end == scores.size());
+                    scores.push_back(errors);
+                });
+                CHECK(scores == expected);
+
+                // best alignment and traceback
+                size_t maxErrors = anchored ? 100 : 5;
+                auto alignment = verifier.align(text, maxErrors, anchored);
+                auto bestScore = std::ranges::min(expected);
+                if (bestScore > maxErrors) {
+                    CHECK(!alignment);
+                    continue;
+                }
+                REQUIRE(alignment);
+                CHECK(alignment->errors == bestScore);
+                CHECK(expected[alignment->end] == bestScore);
+                if (anchored) {
+                    CHECK(alignment->begin == 0);
+                }
+                auto [aligned, errors] = applyTranscript(query, text, *alignment);
+                CHECK(errors == alignment->errors);
+                CHECK(aligned == std::vector<uint8_t>(text.begin() + alignment->begin, text.begin() + alignment->end));
+            }
+        }
+    }
+
+    SECTION("verifying located hits") {
+        auto input = std::vector<std::vector<uint8_t>>{randomSeq(200), randomSeq(100)};
+        auto index = fmc::BiFMIndex<5>{input, /*samplingRate*/4, /*threadNbr*/1};
+        index.isa  = fmc::SampledISA{index, 8};
+
+        auto query = std::vector<uint8_t>(input[1].begin() + 40, input[1].begin() + 70);
+        query.erase(query.begin() + 10);
+        auto verifier = fmc::MyersVerifier{query};
+
+        auto alignment = fmc::verifyHit(index, verifier, /*seqId*/1, /*pos*/40, /*maxErrors*/2);
+        REQUIRE(alignment);
+        CHECK(alignment->errors == 1);
+        CHECK(alignment->begin == 40);
+        CHECK(alignment->end == 70);
+
+        // hit at the end of a sequence, window is clipped
+        auto tail = std::vector<uint8_t>(input[0].end() - 20, input[0].end());
+        alignment = fmc::verifyHit(index, fmc::MyersVerifier{tail}, /*seqId*/0, /*pos*/180, /*maxErrors*/2);
+        REQUIRE(alignment);
+        CHECK(alignment->errors == 0);
+        CHECK(alignment->end == 200);
+
+        CHECK(!fmc::verifyHit(index, verifier, /*seqId*/0, /*pos*/40, /*maxErrors*/2));
+    }
+}
@@ -6,9 +6,17 @@
 #include "../string/utils.h"
 
 #include <catch2/catch_all.hpp>
+#include <fmindex-collection/bitvector/EliasFanoBitvector.h>
 #include <fmindex-collection/fmindex/BiFMIndex.h>
+#include <fmindex-collection/fmindex/BiFMIndexCursor.h>
+#include <fmindex-collection/fmindex/FMIndex.h>
+#include <fmindex-collection/fmindex/diskStorage.h>
+#include <fmindex-collection/locate.h>
+#include <fmindex-collection/memoryPlacement.h>
 #include <fmindex-collection/suffixarray/CSA.h>
+#include <fmindex-collection/string/RunLengthEncoded.h>
 #include <fstream>
+#include <random>
 
 TEST_CASE("checking bidirectional fm index", "[bifmindex]") {
     auto bwt    = std::vector<uint8_t>{'t', '\0', 'o', '\0', ' ', 'H', 'W', 'a', 'l', 'e', 'l', 'l'};
@@ -125,6 +133,25 @@ TEST_CASE("checking bidirectional fm index", "[bifmindex]") {
             auto archive = cereal::BinaryInputArchive{ifs};
             archive(index);
 
+            REQUIRE(index.size() == bwt.size());
+            for (size_t i{0}; i < sa.size(); ++i) {
+                CHECK(index.locate(i) == std::make_tuple(0, sa[i], 0));
+            }
+        }
+    }
+    SECTION("memory mapped serialization/deserialization") {
+        SECTION("serialize") {
+            auto bitStack = std::vector<bool>{};
+            for (size_t i{0}; i < sa.size(); ++i) {
+                bitStack.push_back(true);
+            }
+            auto csa = fmc::CSA{sa, bitStack, /*.threadNbr=*/63, /*.seqCount=*/1};
+            auto index = fmc::BiFMIndex<255>{bwt, bwtRev, fmc::suffixarray::convertCSAToAnnotatedDocument(csa)};
+            fmc::saveIndexMMap(index, "temp_test_serialization_mmap");
+        }
+        SECTION("deserialize") {
+            auto index = fmc::loadIndexMMap<fmc::BiFMIndex<255>>("temp_test_serialization_mmap");
+
             REQUIRE(index.size() == bwt.size());
             for (size_t i{0}; i < sa.size(); ++i) {
                 CHECK(index.locate(i) == std::make_tuple(0, sa[i], 0));
@@ -220,3 +247,303 @@ TEST_CASE("checking bidirectional fm index on longer text (more than 256 chars)"
         }
     }
 }
+
+TEST_CASE("checking batched locate", "[bifmindex][locate]") {
+    auto rng   = std::mt19937{42};
+    auto input = fmc::test::generateText(rng, {1000, 1, 517, 64});
+    auto index = fmc::BiFMIndex<5>{input, /*samplingRate*/16, /*threadNbr*/1};
+
+    auto expected = std::vector<std::tuple<size_t, size_t>>{};
+    for (size_t i{0}; i < index.size(); ++i) {
+        auto [seqId, pos, offset] = index.locate(i);
+        expected.emplace_back(seqId, pos + offset);
+    }
+
+    SECTION("rows") {
+        auto rows = std::vector<size_t>(index.size());
+        std::iota(rows.begin(), rows.end(), 0);
+        std::ranges::reverse(rows);
+        auto expectedRows = expected;
+        std::ranges::reverse(expectedRows);
+
+        for (size_t threadNbr : {1, 3}) {
+            for (size_t batchSize : {1, 7, 32}) {
+                CHECK(fmc::locateBatch(index, rows, threadNbr, batchSize) == expectedRows);
+            }
+        }
+    }
+
+    SECTION("cursors") {
+        using Cursor = fmc::LeftBiFMIndexCursor<decltype(index)>;
+        auto cursors = std::vector<Cursor>{
+            Cursor{index, 5, 100, 0},
+            Cursor{index, 0, 0, 0},
+            Cursor{index, 200, index.size()-200, 0},
+            Cursor{index, 0, 10, 0},
+        };
+        auto expectedCursors = std::vector<std::tuple<size_t, size_t>>{};
+        for (auto const& cur : cursors) {
+            for (size_t i{cur.lb}; i < cur.lb + cur.len; ++i) {
+                expectedCursors.push_back(expected[i]);
+            }
+        }
+
+        for (size_t threadNbr : {1, 3}) {
+            CHECK(fmc::locateBatch(index, cursors, threadNbr) == expectedCursors);
+        }
+    }
+}
+
+TEST_CASE("checking multi threaded construction of bidirectional fm index", "[bifmindex][threads]") {
+    auto rng   = std::mt19937{7};
+    auto input = fmc::test::generateText(rng, {5000, 13, 700});
+    auto expected = fmc::BiFMIndex<5>{input, /*samplingRate*/4, /*threadNbr*/1};
+
+    for (size_t threadNbr : {2, 3})
+    for (bool concurrentBuild : {false, true}) {
+        INFO(threadNbr << " " << concurrentBuild);
+        auto index = fmc::BiFMIndex<5>{input, /*samplingRate*/4, threadNbr, /*seqOffset*/0, /*includeReversedInput*/false, concurrentBuild};
+        REQUIRE(index.size() == expected.size());
+        CHECK(index.C == expected.C);
+        for (size_t i{0}; i < index.size(); ++i) {
+            CHECK(index.bwt.symbol(i) == expected.bwt.symbol(i));
+            CHECK(index.bwtRev.symbol(i) == expected.bwtRev.symbol(i));
+            CHECK(index.locate(i) == expected.locate(i));
+        }
+    }
+}
+
+TEST_CASE("checking run length encoded bidirectional fm index", "[bifmindex][runlength]") {
+    // highly repetitive input, multiple copies of the same sequence with few mutations
+    auto rng  = std::mt19937{5};
+    auto base = fmc::test::generateText(rng, {2000})[0];
+    auto input = std::vector<std::vector<uint8_t>>{};
+    for (size_t i{0}; i < 20; ++i) {
+        auto& seq = input.emplace_back(base);
+        seq[rng() % seq.size()] = 1 + rng() % 4;
+    }
+
+    // samples are sparse, an Elias-Fano bitvector marks them in O(n/samplingRate) space
+    using SA      = fmc::suffixarray::SparseArray<std::tuple<uint32_t, uint32_t>, fmc::bitvector::EliasFanoBitvector<>>;
+    using Index   = fmc::BiFMIndex<5, fmc::string::RunLengthEncoded_512_64k, SA>;
+    auto expected = fmc::BiFMIndex<5>{input, /*samplingRate*/64, /*threadNbr*/1};
+    auto index    = Index{input, /*samplingRate*/64, /*threadNbr*/1};
+
+    REQUIRE(index.size() == expected.size());
+    CHECK(index.C == expected.C);
+    CHECK(index.bwt.runs() < index.size() / 10);
+    CHECK(index.annotatedArray.bv.space_usage() * 8 < index.size() / 4);
+    for (size_t i{0}; i < index.size(); ++i) {
+        INFO(i);
+        CHECK(index.bwt.symbol(i) == expected.bwt.symbol(i));
+        CHECK(index.bwtRev.symbol(i) == expected.bwtRev.symbol(i));
+        CHECK(index.bwt.all_ranks(i) == expected.bwt.all_ranks(i));
+        CHECK(index.locate(i) == expected.locate(i));
+    }
+}
+
+TEST_CASE("checking extraction of substrings via the sampled inverse suffix array", "[bifmindex][extract]") {
+    auto rng   = std::mt19937{7};
+    auto input = fmc::test::generateText(rng, {1, 17, 64, 100, 3});
+
+    auto check = [&](auto const& index, size_t seqOffset) {
+        for (size_t samplingRate : {1, 3, 16}) {
+            for (size_t threadNbr : {1, 2}) {
+                auto isa = fmc::SampledISA{index, samplingRate, threadNbr};
+                REQUIRE(isa.size() == input.size());
+                CHECK(isa.firstSeqId == seqOffset);
+
+                // inverse of the suffix array
+                for (size_t i{0}; i < index.size(); ++i) {
+                    auto [seqId, pos, offset] = index.locate(i);
+                    CHECK(isa.inverse(index, seqId, pos + offset) == i);
+                }
+
+                // all substrings
+                for (size_t seqId{0}; seqId < input.size(); ++seqId) {
+                    auto const& seq = input[seqId];
+                    CHECK(isa.length(seqId + seqOffset) == seq.size());
+                    for (size_t begin{0}; begin <= seq.size(); ++begin) {
+                        for (size_t end{begin}; end <= seq.size(); ++end) {
+                            INFO(samplingRate << " " << seqId << " [" << begin << ", " << end << ")");
+                            auto expected = std::vector<uint8_t>(seq.begin() + begin, seq.begin() + end);
+                            CHECK(isa.extract(index, seqId + seqOffset, begin, end) == expected);
+                        }
+                    }
+                }
+                CHECK_THROWS(isa.extract(index, seqOffset, 0, input[0].size() + 1));
+                CHECK_THROWS(isa.extract(index, seqOffset + input.size(), 0, 0));
+            }
+        }
+    };
+
+    SECTION("FMIndex") {
+        auto index = fmc::FMIndex<5>{input, /*samplingRate*/4, /*threadNbr*/1};
+        check(index, 0);
+
+        index.isa = fmc::SampledISA{index, 8};
+        CHECK(index.extract(3, 10, 20) == std::vector<uint8_t>(input[3].begin() + 10, input[3].begin() + 20));
+    }
+    SECTION("BiFMIndex") {
+        auto index = fmc::BiFMIndex<5>{input, /*samplingRate*/4, /*threadNbr*/1, /*seqOffset*/5};
+        check(index, 5);
+
+        CHECK_THROWS(index.extract(5, 0, 1)); // isa not initialized
+        index.isa = fmc::SampledISA{index, 8};
+        CHECK(index.extract(8, 10, 20) == std::vector<uint8_t>(input[3].begin() + 10, input[3].begin() + 20));
+
+        // isa and kmerLookup are not part of the index file, they are stored in a separate file
+        index.kmerLookup = fmc::KMerLookupTable{index, /*.k=*/2};
+        fmc::saveIndex(index, "temp_test_serialization_lookups");
+        fmc::saveIndexTables(index, "temp_test_serialization_lookups.tables");
+
+        auto plain = fmc::BiFMIndex<5>{input, /*samplingRate*/4, /*threadNbr*/1, /*seqOffset*/5};
+        fmc::saveIndex(plain, "temp_test_serialization_plain");
+        auto readFile = [](std::string const& path) {
+            auto ifs = std::ifstream{path, std::ios::binary};
+            return std::string{std::istreambuf_iterator<char>{ifs}, {}};
+        };
+        CHECK(readFile("temp_test_serialization_lookups") == readFile("temp_test_serialization_plain"));
+
+        auto loaded = fmc::loadIndex<fmc::BiFMIndex<5>>("temp_test_serialization_lookups");
+        CHECK(loaded.kmerLookup.k == 0);
+        CHECK_THROWS(loaded.extract(8, 10, 20));
+        fmc::loadIndexTables(loaded, "temp_test_serialization_lookups.tables");
+        CHECK(loaded.kmerLookup.k == 2);
+        CHECK(loaded.kmerLookup.entries.size() == index.kmerLookup.entries.size());
+        CHECK(loaded.extract(8, 10, 20) == std::vector<uint8_t>(input[3].begin() + 10, input[3].begin() + 20));
+
+        fmc::saveIndexMMap(index, "temp_test_serialization_lookups_mmap");
+        fmc::saveIndexTablesMMap(index, "temp_test_serialization_lookups_mmap.tables");
+        auto mapped = fmc::loadIndexMMap<fmc::BiFMIndex<5>>("temp_test_serialization_lookups_mmap");
+        fmc::loadIndexTablesMMap(mapped, "temp_test_serialization_lookups_mmap.tables");
+        CHECK(mapped.kmerLookup.k == 2);
+        CHECK(mapped.kmerLookup.entries.size() == index.kmerLookup.entries.size());
+        CHECK(mapped.extract(8, 10, 20) == std::vector<uint8_t>(input[3].begin() + 10, input[3].begin() + 20));
+    }
+}
+
+TEST_CASE("checking memory mapped round trip of a generated index", "[bifmindex][mmser]") {
+    auto rng   = std::mt19937{13};
+    auto input = fmc::test::generateText(rng, {3000, 1, 250});
+    using Index = fmc::BiFMIndex<5>;
+    auto index = Index{input, /*samplingRate*/8, /*threadNbr*/1};
+    index.kmerLookup = fmc::KMerLookupTable{index, /*.k=*/3};
+    index.isa        = fmc::SampledISA{index, 16};
+
+    fmc::saveIndexMMap(index, "temp_test_roundtrip_mmap");
+    fmc::saveIndexTablesMMap(index, "temp_test_roundtrip_mmap.tables");
+
+    auto check = [&](Index const& loaded) {
+        REQUIRE(loaded.size() == index.size());
+        CHECK(loaded.C == index.C);
+        for (size_t i{0}; i < index.size(); ++i) {
+            INFO(i);
+            CHECK(loaded.bwt.symbol(i) == index.bwt.symbol(i));
+            CHECK(loaded.bwtRev.symbol(i) == index.bwtRev.symbol(i));
+            CHECK(loaded.locate(i) == index.locate(i));
+        }
+        REQUIRE(loaded.kmerLookup.k == index.kmerLookup.k);
+        REQUIRE(loaded.kmerLookup.entries.size() == index.kmerLookup.entries.size());
+        for (size_t i{0}; i < index.kmerLookup.entries.size(); ++i) {
+            INFO(i);
+            auto const& e = index.kmerLookup.entries[i];
+            auto const& l = loaded.kmerLookup.entries[i];
+            CHECK(std::tie(l.lb, l.lbRev, l.len) == std::tie(e.lb, e.lbRev, e.len));
+        }
+        CHECK(loaded.extract(2, 0, 250) == input[2]);
+        CHECK(loaded.extract(0, 1000, 1100) == std::vector<uint8_t>(input[0].begin() + 1000, input[0].begin() + 1100));
+    };
+
+    auto loaded = fmc::loadIndexMMap<Index>("temp_test_roundtrip_mmap");
+    fmc::loadIndexTablesMMap(loaded, "temp_test_roundtrip_mmap.tables");
+    check(loaded);
+
+    // the mapping must stay valid after moving the loaded index
+    auto moved = std::move(loaded);
+    check(moved);
+
+    // saving a mapped index writes the same files again
+    fmc::saveIndexMMap(moved, "temp_test_roundtrip_mmap2");
+    fmc::saveIndexTablesMMap(moved, "temp_test_roundtrip_mmap2.tables");
+    auto readFile = [](std::string const& path) {
+        auto ifs = std::ifstream{path, std::ios::binary};
+        return std::string{std::istreambuf_iterator<char>{ifs}, {}};
+    };
+    CHECK(readFile("temp_test_roundtrip_mmap") == readFile("temp_test_roundtrip_mmap2"));
+    CHECK(readFile("temp_test_roundtrip_mmap.tables") == readFile("temp_test_roundtrip_mmap2.tables"));
+}
+
+TEST_CASE("checking huge page advice and numa replicas", "[bifmindex][memory]") {
+    auto rng   = std::mt19937{11};
+    auto input = fmc::test::generateText(rng, {100000, 50000});
+    using Index = fmc::BiFMIndex<5>;
+    auto index = Index{input, /*samplingRate*/16, /*threadNbr*/1};
+
+    SECTION("all arrays are visited") {
+        size_t bytes{};
+        fmc::forEachArray(index, [&](std::byte const*, size_t b) {
+            bytes += b;
+        });
+        // bwt and bwtRev are visited, they hold at least 3 bits per symbol each
+        CHECK(bytes >= 2 * index.size() * 3 / 8);
+    }
+
+    SECTION("advising huge pages") {
+        auto policy = fmc::HugePagePolicy{.pageSize = 4096, .minBytes = 4096};
+        auto report = fmc::adviseHugePages(index, policy);
+        CHECK(report.arrays + report.failed > 0);
+
+        // with transparent huge pages available, every array covering a full page is advised
+        auto thp  = std::ifstream{"/sys/kernel/mm/transparent_hugepage/enabled"};
+        auto mode = std::string{std::istreambuf_iterator<char>{thp}, {}};
+        if (thp && mode.find("[never]") == std::string::npos) {
+            size_t arrays{}, bytes{};
+            fmc::forEachArray(index, [&](std::byte const* ptr, size_t b) {
+                auto begin = (reinterpret_cast<uintptr_t>(ptr) + policy.pageSize - 1) / policy.pageSize;
+                auto end   = (reinterpret_cast<uintptr_t>(ptr) + b) / policy.pageSize;
+                if (b < policy.minBytes || begin >= end) return;
+                arrays += 1;
+                bytes  += b;
+            });
+            CHECK(arrays > 0);
+            CHECK(report.arrays == arrays);
+            CHECK(report.bytes == bytes);
+        }
+
+        // too large page sizes are skipped
+        policy = fmc::HugePagePolicy{.minBytes = size_t{1} << 40};
+        report = fmc::adviseHugePages(index, policy);
+        CHECK(report.arrays == 0);
+        CHECK(report.failed == 0);
+    }
+
+    SECTION("parsing cpu lists") {
+        CHECK(fmc::numa::parseCpuList("0-3,8,10-11\n") == std::vector<size_t>{0, 1, 2, 3, 8, 10, 11});
+        CHECK(fmc::numa::parseCpuList("").empty());
+        auto topology = fmc::numa::Topology{{{0, 1}, {2, 3}}};
+        CHECK(topology.nodeCount() == 2);
+        CHECK(topology.nodeOfCpu(3) == 1);
+        CHECK(topology.nodeOfCpu(7) == 0);
+        CHECK(fmc::numa::Topology::detect().nodeCount() >= 1);
+    }
+
+    SECTION("replicas") {
+        auto cpus     = std::vector<size_t>{fmc::numa::currentCpu()};
+        auto topology = fmc::numa::Topology{{cpus, cpus}};
+        auto create   = [&]() { return Index{input, /*samplingRate*/16, /*threadNbr*/1}; };
+
+        auto replicas = fmc::NumaReplicas<Index>{create, /*replicate*/true, topology};
+        REQUIRE(replicas.size() == 2);
+        CHECK(&replicas[0] != &replicas[1]);
+        CHECK(&replicas.local() == &replicas[0]);
+        for (size_t i{0}; i < index.size(); i += 97) {
+            CHECK(replicas[1].locate(i) == index.locate(i));
+            CHECK(replicas[1].bwt.symbol(i) == index.bwt.symbol(i));
+        }
+
+        auto single = fmc::NumaReplicas<Index>{create, /*replicate*/false, topology};
+        CHECK(single.size() == 1);
+        CHECK(&single.local() == &single[0]);
+    }
+}
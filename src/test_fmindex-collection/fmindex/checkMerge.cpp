@@ -5,9 +5,12 @@
 #include "../string/allStrings.h"
 
 #include <catch2/catch_all.hpp>
+#include <fmindex-collection/fmindex/DeltaIndex.h>
 #include <fmindex-collection/fmindex/FMIndex.h>
 #include <fmindex-collection/fmindex/merge.h>
+#include <fmindex-collection/search/SearchNoErrors.h>
 #include <fmindex-collection/suffixarray/DenseCSA.h>
+#include <random>
 
 TEST_CASE("checking merging of fmindices", "[FMIndex][merge]") {
 
@@ -243,3 +246,222 @@ TEST_CASE("checking merging of fmindices", "[BiFMIndex][merge]") {
         }
     }
 }
+
+namespace {
+// collects all hits of all 3-mers over the alphabet {1, 2, 3}
+template <typename Index>
+auto allHits(Index const& index) {
+    auto hits = std::vector<std::tuple<size_t, size_t, size_t>>{};
+    for (size_t kmer{0}; kmer < 27; ++kmer) {
+        auto query = std::vector<uint8_t>{uint8_t(1 + kmer % 3), uint8_t(1 + kmer / 3 % 3), uint8_t(1 + kmer / 9)};
+        auto cursor = fmc::search_no_errors::search(index, query);
+        for (size_t i{cursor.lb}; i < cursor.lb + cursor.len; ++i) {
+            auto [seq, pos, offset] = index.locate(i);
+            hits.emplace_back(kmer, seq, pos + offset);
+        }
+    }
+    std::ranges::sort(hits);
+    return hits;
+}
+}
+
+TEST_CASE("checking construction with a memory budget", "[BiFMIndex][merge][budget]") {
+    auto rng  = std::mt19937{3};
+    auto data = fmc::test::generateText(rng, {50, 120, 7, 33, 200, 1, 64}, /*.symbols=*/3);
+
+    using Index  = fmc::BiFMIndex<4>;
+    auto expected = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+
+    for (size_t budget : {0, 500, 1500, 100'000}) {
+        INFO(budget);
+        auto index = fmc::fmindex::createWithMemoryBudget<Index>(data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1, budget);
+        REQUIRE(index.size() == expected.size());
+        CHECK(index.C == expected.C);
+        CHECK(reconstructText(index) == data);
+        CHECK(allHits(index) == allHits(expected));
+    }
+
+    SECTION("empty input") {
+        auto index = fmc::fmindex::createWithMemoryBudget<Index>(std::vector<std::vector<uint8_t>>{}, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1, /*.memoryBudget =*/ 1000);
+        CHECK(index.size() == 0);
+    }
+}
+
+TEST_CASE("checking parallel merging", "[FMIndex][BiFMIndex][merge][threads]") {
+    auto rng   = std::mt19937{5};
+    auto data1 = fmc::test::generateText(rng, {300, 20, 1000}, /*.symbols=*/3);
+    auto data2 = fmc::test::generateText(rng, {70000, 4, 500, 90}, /*.symbols=*/3);
+
+    SECTION("FMIndex") {
+        using Index  = fmc::FMIndex<4>;
+        auto index1 = Index{data1, /*.samplingRate =*/ 4, /*.threadNbr =*/ 1};
+        auto index2 = Index{data2, /*.samplingRate =*/ 4, /*.threadNbr =*/ 1, /*.useDelimiter=*/true, /*.seqOffset=*/data1.size()};
+
+        auto expected = fmc::fmindex::merge(index1, index2);
+        auto index    = fmc::fmindex::merge(index1, index2, /*.threadNbr=*/3);
+        REQUIRE(index.size() == expected.size());
+        CHECK(index.C == expected.C);
+        for (size_t i{0}; i < index.size(); ++i) {
+            INFO(i);
+            CHECK(index.bwt.symbol(i) == expected.bwt.symbol(i));
+            CHECK(index.locate(i) == expected.locate(i));
+        }
+    }
+
+    SECTION("BiFMIndex") {
+        using Index  = fmc::BiFMIndex<4>;
+        auto index1 = Index{data1, /*.samplingRate =*/ 4, /*.threadNbr =*/ 1};
+        auto index2 = Index{data2, /*.samplingRate =*/ 4, /*.threadNbr =*/ 1, /*.seqOffset=*/data1.size()};
+
+        auto expected = fmc::fmindex::merge(index1, index2);
+        auto index    = fmc::fmindex::merge(index1, index2, /*.threadNbr=*/3);
+        REQUIRE(index.size() == expected.size());
+        CHECK(index.C == expected.C);
+        for (size_t i{0}; i < index.size(); ++i) {
+            INFO(i);
+            CHECK(index.bwt.symbol(i) == expected.bwt.symbol(i));
+            CHECK(index.bwtRev.symbol(i) == expected.bwtRev.symbol(i));
+            CHECK(index.locate(i) == expected.locate(i));
+        }
+        CHECK(reconstructText(index).size() == data1.size() + data2.size());
+    }
+}
+
+TEST_CASE("checking k-way merging", "[FMIndex][BiFMIndex][merge][kway]") {
+    auto rng  = std::mt19937{11};
+    auto data = fmc::test::generateText(rng, {50, 120, 7, 33, 200, 1, 64, 90, 17}, /*.symbols=*/3);
+    // split data into groups of sequences
+    auto groups = std::vector<std::tuple<size_t, size_t>>{{0, 2}, {2, 3}, {3, 6}, {6, 7}, {7, 9}};
+
+    SECTION("FMIndex") {
+        using Index = fmc::FMIndex<4>;
+        auto expected = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+        for (size_t k : {1, 2, 5}) {
+            INFO(k);
+            auto indices = std::vector<Index>{};
+            for (size_t i{0}; i < k; ++i) {
+                auto [begin, end] = groups[i];
+                if (i+1 == k) end = data.size();
+                auto group = std::vector<std::vector<uint8_t>>{data.begin() + begin, data.begin() + end};
+                indices.emplace_back(group, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1, /*.useDelimiter=*/true, /*.seqOffset=*/begin);
+            }
+            for (size_t threadNbr : {1, 3}) {
+                auto index = fmc::fmindex::merge(indices, threadNbr);
+                REQUIRE(index.size() == expected.size());
+                CHECK(index.C == expected.C);
+                CHECK(allHits(index) == allHits(expected));
+            }
+        }
+    }
+
+    SECTION("BiFMIndex") {
+        using Index = fmc::BiFMIndex<4>;
+        auto expected = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+        for (size_t k : {1, 2, 5}) {
+            INFO(k);
+            auto indices = std::vector<Index>{};
+            for (size_t i{0}; i < k; ++i) {
+                auto [begin, end] = groups[i];
+                if (i+1 == k) end = data.size();
+                auto group = std::vector<std::vector<uint8_t>>{data.begin() + begin, data.begin() + end};
+                indices.emplace_back(group, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1, /*.seqOffset=*/begin);
+            }
+            for (size_t threadNbr : {1, 3}) {
+                auto index = fmc::fmindex::merge(indices, threadNbr);
+                REQUIRE(index.size() == expected.size());
+                CHECK(index.C == expected.C);
+                CHECK(reconstructText(index) == data);
+                CHECK(allHits(index) == allHits(expected));
+            }
+        }
+    }
+}
+
+TEST_CASE("checking appending of sequences", "[BiFMIndex][merge][append]") {
+    using Index = fmc::BiFMIndex<4>;
+
+    auto rng  = std::mt19937{13};
+    auto data = fmc::test::generateText(rng, {27, 1, 80, 5, 63, 12, 44, 2, 71, 38, 9, 56}, /*.symbols=*/3);
+    auto expected = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+    auto initial  = std::vector<std::vector<uint8_t>>{data.begin(), data.begin() + 4};
+
+    // all hits over the main index and all deltas
+    auto deltaHits = [](fmc::DeltaIndex<Index> const& index) {
+        auto hits = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        index.forEachIndex([&](Index const& i) {
+            auto h = allHits(i);
+            hits.insert(hits.end(), h.begin(), h.end());
+        });
+        std::ranges::sort(hits);
+        return hits;
+    };
+
+    SECTION("append") {
+        auto index = Index{initial, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+        for (size_t i{4}; i < data.size(); i += 3) {
+            auto group = std::vector<std::vector<uint8_t>>{data.begin() + i, data.begin() + std::min(i + 3, data.size())};
+            index = fmc::fmindex::append(index, group, /*.samplingRate =*/ 3, /*.threadNbr =*/ 2, /*.seqOffset =*/ i);
+        }
+        REQUIRE(index.size() == expected.size());
+        CHECK(index.C == expected.C);
+        CHECK(reconstructText(index) == data);
+        CHECK(allHits(index) == allHits(expected));
+    }
+
+    SECTION("DeltaIndex") {
+        auto index = fmc::DeltaIndex<Index>{Index{initial, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1}, /*.seqCount =*/ 4, /*.samplingRate =*/ 3};
+        for (size_t i{4}; i < 8; ++i) {
+            CHECK(index.append(std::vector<std::vector<uint8_t>>{data[i]}) == i);
+        }
+        CHECK(index.deltas.size() == 1); // four equally sized appends collapse into a single delta
+
+        index.startCompaction();
+        // appending while compacting creates new deltas
+        for (size_t i{8}; i < data.size(); ++i) {
+            CHECK(index.append(std::vector<std::vector<uint8_t>>{data[i]}) == i);
+        }
+        CHECK(index.size() == expected.size());
+        CHECK(deltaHits(index) == allHits(expected));
+
+        CHECK(index.finishCompaction(/*._wait=*/true));
+        CHECK(index.deltas.size() == 1);
+        CHECK(deltaHits(index) == allHits(expected));
+
+        index.compact();
+        CHECK(index.deltas.empty());
+        CHECK(index.main.size() == expected.size());
+        CHECK(reconstructText(index.main) == data);
+        CHECK(allHits(index.main) == allHits(expected));
+    }
+
+    SECTION("lookup tables are rebuilt") {
+        auto check = [&](Index const& index) {
+            REQUIRE(index.kmerLookup.k == 3);
+            auto fresh = fmc::KMerLookupTable{index, /*.k=*/3};
+            REQUIRE(index.kmerLookup.entries.size() == fresh.entries.size());
+            for (size_t i{0}; i < fresh.entries.size(); ++i) {
+                CHECK(index.kmerLookup.entries[i].lb == fresh.entries[i].lb);
+                CHECK(index.kmerLookup.entries[i].lbRev == fresh.entries[i].lbRev);
+                CHECK(index.kmerLookup.entries[i].len == fresh.entries[i].len);
+            }
+            REQUIRE(index.isa.samplingRate == 5);
+            for (size_t i{0}; i < data.size(); ++i) {
+                CHECK(index.extract(i, 0, data[i].size()) == data[i]);
+            }
+        };
+
+        auto index = Index{initial, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+        index.kmerLookup = fmc::KMerLookupTable{index, /*.k=*/3};
+        index.isa        = fmc::SampledISA{index, /*.samplingRate=*/5};
+
+        auto appended = fmc::fmindex::append(index, std::vector<std::vector<uint8_t>>{data.begin() + 4, data.end()}, /*.samplingRate =*/ 3, /*.threadNbr =*/ 2, /*.seqOffset =*/ 4);
+        check(appended);
+
+        auto deltaIndex = fmc::DeltaIndex<Index>{std::move(index), /*.seqCount =*/ 4, /*.samplingRate =*/ 3};
+        for (size_t i{4}; i < data.size(); ++i) {
+            deltaIndex.append(std::vector<std::vector<uint8_t>>{data[i]});
+        }
+        deltaIndex.compact();
+        check(deltaIndex.main);
+    }
+}
@@ -0,0 +1,96 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: CC0-1.0
+
+#include <catch2/catch_all.hpp>
+#include <fmindex-collection/fmindex/BiFMIndex.h>
+#include <fmindex-collection/fmindex/FMIndex.h>
+#include <fmindex-collection/fmindex/ShardedIndex.h>
+#include <fmindex-collection/locate.h>
+#include <random>
+
+TEST_CASE("checking sharded indices", "[FMIndex][BiFMIndex][sharded]") {
+    auto rng     = std::mt19937{25};
+    auto data    = fmc::test::generateText(rng, {20, 119, 64, 35, 100, 21, 87, 50, 113, 42}, /*.symbols=*/3);
+    auto queries = fmc::test::sampleQueries(rng, data, 30, {6, 8, 11}, /*.maxSubstitutions=*/0, /*.symbols=*/3);
+
+    using Result = std::tuple<size_t, size_t, size_t, size_t>;
+    auto shardedHits = [&]<typename Index>(fmc::ShardedIndex<Index> const& index, size_t errors, size_t threadNbr) {
+        auto results = std::vector<Result>{};
+        index.template search</*EditDistance=*/true>(queries, errors, [&](size_t qidx, size_t sid, size_t pos, size_t e) {
+            results.emplace_back(qidx, sid, pos, e);
+        }, threadNbr, /*.chunkSize=*/7);
+        return results;
+    };
+
+    SECTION("BiFMIndex") {
+        using Index = fmc::BiFMIndex<4>;
+        auto single = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+
+        for (size_t errors : {0, 1}) {
+            auto expected = std::vector<Result>{};
+            fmc::search</*EditDistance=*/true>(single, queries, errors, [&](size_t qidx, auto const& cursor, size_t e) {
+                for (auto [sid, spos, offset] : fmc::LocateLinear{single, cursor}) {
+                    expected.emplace_back(qidx, sid, spos+offset, e);
+                }
+            });
+            std::ranges::sort(expected);
+            REQUIRE(!expected.empty());
+
+            for (size_t shardCount : {1, 3, 10, 20}) {
+                // 5 threads: more threads than shards for some shard counts, fewer for others
+                for (size_t buildThreadNbr : {1, 5}) {
+                    auto index = fmc::ShardedIndex<Index>{data, shardCount, /*.samplingRate =*/ 3, /*.threadNbr =*/ buildThreadNbr};
+                    CHECK(index.size() == std::min<size_t>(shardCount, data.size()));
+                    CHECK(index.seqCount() == data.size());
+                    for (size_t threadNbr : {1, 4}) {
+                        INFO("errors " << errors << " shards " << shardCount << " build threads " << buildThreadNbr << " threads " << threadNbr);
+                        CHECK(shardedHits(index, errors, threadNbr) == expected);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("FMIndex") {
+        using Index = fmc::FMIndex<4>;
+        auto single = Index{data, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1};
+
+        auto expected = std::vector<Result>{};
+        fmc::search_backtracking::search(single, queries, 1, [&](size_t qidx, auto const& cursor, size_t e) {
+            for (auto [sid, spos, offset] : fmc::LocateLinear{single, cursor}) {
+                expected.emplace_back(qidx, sid, spos+offset, e);
+            }
+        });
+        std::ranges::sort(expected);
+
+        auto index = fmc::ShardedIndex<Index>{data, 4, /*.samplingRate =*/ 3, /*.threadNbr =*/ 2};
+        CHECK(index.size() == 4);
+        CHECK(shardedHits(index, 1, 3) == expected);
+    }
+
+    SECTION("independently built shards") {
+        using Index = fmc::BiFMIndex<4>;
+        auto single = fmc::ShardedIndex<Index>{data, 1, /*.samplingRate =*/ 3};
+
+        auto index = fmc::ShardedIndex<Index>{};
+        for (size_t begin : {0, 4, 5}) {
+            auto end   = (begin == 5) ? data.size() : begin + (begin == 0 ? 4 : 1);
+            auto group = std::vector<std::vector<uint8_t>>{data.begin() + begin, data.begin() + end};
+            CHECK(index.seqCount() == begin);
+            index.appendShard(Index{group, /*.samplingRate =*/ 3, /*.threadNbr =*/ 1, /*.seqOffset =*/ begin}, group.size());
+        }
+        CHECK(index.size() == 3);
+        CHECK(index.shardOf(0) == 0);
+        CHECK(index.shardOf(3) == 0);
+        CHECK(index.shardOf(4) == 1);
+        CHECK(index.shardOf(9) == 2);
+        CHECK(shardedHits(index, 1, 2) == shardedHits(single, 1, 1));
+
+        // rebuilding a shard with different sequences only changes the hits of its sequences
+        auto modified = data;
+        std::ranges::reverse(modified[4]);
+        index.rebuildShard(1, std::vector<std::vector<uint8_t>>{modified[4]}, /*.samplingRate =*/ 2, /*.threadNbr =*/ 2);
+        CHECK(shardedHits(index, 1, 2) == shardedHits(fmc::ShardedIndex<Index>{modified, 2, /*.samplingRate =*/ 3}, 1, 1));
+        CHECK_THROWS(index.rebuildShard(2, std::vector<std::vector<uint8_t>>{data[5]}, /*.samplingRate =*/ 3));
+    }
+}
@@ -132,3 +132,59 @@ TEST_CASE("benchmark searches with errors", "[searches][!benchmark][bifmindex]")
         }
     }
 }
+
+TEST_CASE("benchmark hybrid search against search_ng26", "[searches][!benchmark][bifmindex][hybrid]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    srand(0);
+
+    auto ref = std::vector<std::vector<uint8_t>>{};
+    for (size_t i{0}; i < 10; ++i) {
+        auto& seq = ref.emplace_back();
+        for (size_t j{0}; j < 1'000'000; ++j) {
+            seq.emplace_back(1 + rand()%4);
+        }
+    }
+
+    // reads with up to two substitutions
+    size_t len = 150;
+    auto reads = std::vector<std::vector<uint8_t>>{};
+    for (size_t i{0}; i < 1000; ++i) {
+        auto const& seq = ref[rand() % ref.size()];
+        auto pos = rand() % (seq.size() - len);
+        auto& read = reads.emplace_back(seq.begin() + pos, seq.begin() + pos + len);
+        for (size_t j{0}, n = rand() % 3; j < n; ++j) {
+            read[rand() % len] = 1 + rand()%4;
+        }
+    }
+
+    auto index = Index{ref, /*samplingRate*/16, /*threadNbr*/1};
+    index.isa  = fmc::SampledISA{index, 16};
+
+    for (size_t errors{1}; errors < 3; ++errors) {
+        static auto bench = ankerl::nanobench::Bench();
+        bench.batch(reads.size())
+             .relative(true);
+
+        bench.run("search ng26 + locate - errors " + std::to_string(errors), [&]() {
+            fmc::search_ng26::search(index, reads, errors, [&](auto qidx, auto cursor, auto errors) {
+                for (auto res : fmc::LocateLinear{index, cursor}) {
+                    ankerl::nanobench::doNotOptimizeAway(res);
+                }
+                (void)errors;
+                (void)qidx;
+            });
+        });
+
+        for (size_t threshold : {4, 16, 64}) {
+            bench.run("search hybrid, threshold " + std::to_string(threshold) + " - errors " + std::to_string(errors), [&]() {
+                fmc::search_hybrid::search(index, reads, errors, threshold, [&](auto qidx, auto seqId, auto pos, auto errors) {
+                    ankerl::nanobench::doNotOptimizeAway(pos);
+                    (void)seqId;
+                    (void)errors;
+                    (void)qidx;
+                });
+            });
+        }
+    }
+}
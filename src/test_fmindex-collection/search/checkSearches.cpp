@@ -6,10 +6,19 @@
 #include <fmindex-collection/fmindex/BiFMIndex.h>
 #include <fmindex-collection/locate.h>
 #include <fmindex-collection/search/all.h>
+#include <fmindex-collection/search/Instrumentation.h>
+#include <fmindex-collection/search/SchemeTuner.h>
+#include <fmindex-collection/search/SearchNg28.h>
 #include <fmindex-collection/search_scheme/generator/all.h>
 #include <fmindex-collection/search_scheme/expand.h>
+#include <fmindex-collection/search_scheme/isComplete.h>
 #include <fmindex-collection/string/all.h>
 #include <nanobench.h>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+#include <random>
+#include <thread>
 
 TEST_CASE("check searches with errors", "[searches][errors]") {
     using Index = fmc::BiFMIndex<256>;
@@ -116,6 +125,33 @@ TEST_CASE("check searches with errors", "[searches][errors]") {
         CHECK(results == expected);
     }
 
+    SECTION("search no errors, interleaved batches") {
+        auto queries = std::vector<std::vector<uint8_t>> {
+            {'A', 'A'}, {'C', 'A'}, {'B', 'B'}, {}, {'A', 'B', 'A'}, {'A', 'A', 'A', 'C'}, {'C'}, {'A', 'A', 'B', 'A', 'A'},
+        };
+
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        for (size_t qidx{0}; qidx != queries.size(); ++qidx) {
+            auto cursor = fmc::search_no_errors::search(index, queries[qidx]);
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                expected.emplace_back(qidx, sid, spos+offset);
+            }
+        }
+        std::ranges::sort(expected);
+
+        for (size_t batchSize : {1, 2, 3, 32}) {
+            auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+            fmc::search_no_errors::search(index, queries, [&](auto qidx, auto cursor) {
+                for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                    results.emplace_back(qidx, sid, spos+offset);
+                }
+            }, batchSize);
+
+            std::ranges::sort(results);
+            CHECK(results == expected);
+        }
+    }
+
     SECTION("search one error, all search") {
         auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
         fmc::search_one_error::search(index, queries, [&](auto qidx, auto cursor, auto errors) {
@@ -1489,6 +1525,75 @@ TEST_CASE("check searches with errors", "[searches][errors]") {
         CHECK(results == expected);
     }
 
+    SECTION("search, parallel search, no search scheme") {
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search</*EditDistance=*/true>(index, queries, /*.maxErrors=*/1, [&](auto qidx, auto cursor, auto errors) {
+            (void)errors;
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                expected.emplace_back(qidx, sid, spos+offset);
+            }
+        });
+
+        auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search_parallel</*EditDistance=*/true>(index, queries, /*.maxErrors=*/1, /*.threadNbr=*/4, [&](auto qidx, auto cursor, auto errors) {
+            (void)errors;
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                results.emplace_back(qidx, sid, spos+offset);
+            }
+        }, /*.chunkSize=*/1);
+
+        // same order as the single threaded search
+        CHECK(results == expected);
+    }
+
+    SECTION("search, parallel search, many chunks") {
+        // more chunks than workers may run ahead of the reported chunk
+        auto manyQueries = std::vector<std::vector<uint8_t>>{};
+        for (size_t i{0}; i < 100; ++i) {
+            manyQueries.insert(manyQueries.end(), queries.begin(), queries.end());
+        }
+
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search</*EditDistance=*/true>(index, manyQueries, /*.maxErrors=*/1, [&](auto qidx, auto cursor, auto errors) {
+            (void)errors;
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                expected.emplace_back(qidx, sid, spos+offset);
+            }
+        });
+
+        auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search_parallel</*EditDistance=*/true>(index, manyQueries, /*.maxErrors=*/1, /*.threadNbr=*/4, [&](auto qidx, auto cursor, auto errors) {
+            (void)errors;
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                results.emplace_back(qidx, sid, spos+offset);
+            }
+        }, /*.chunkSize=*/1);
+
+        CHECK(results == expected);
+    }
+
+    SECTION("search, parallel search_n, no search scheme") {
+        auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search_n_parallel</*EditDistance=*/true>(index, queries, /*.maxErrors=*/1, /*.n=*/3, /*.threadNbr=*/4, [&](auto qidx, auto cursor, auto errors) {
+            (void)errors;
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                results.emplace_back(qidx, sid, spos+offset);
+            }
+        }, /*.chunkSize=*/1);
+
+        std::ranges::sort(results);
+
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>> {
+            {0, 0, 3},
+            {0, 1, 7},
+            {0, 1, 7},
+            {1, 0, 7},
+            {1, 0, 7},
+            {1, 1, 3},
+        };
+        CHECK(results == expected);
+    }
+
     SECTION("simple search, all search") {
         auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
         fmc::Search {
@@ -1570,4 +1675,567 @@ TEST_CASE("check searches with errors", "[searches][errors]") {
         };
         CHECK(results == expected);
     }
+
+    SECTION("simple search, parallel search") {
+        auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::Search {
+            .index      = index,
+            .queries    = queries,
+            .errors     = 1,
+            .threadNbr  = 4,
+            .reportFunc = [&](auto qidx, auto sid, auto spos, auto errors) {
+                (void)errors;
+                results.emplace_back(qidx, sid, spos);
+            },
+        }();
+
+        std::ranges::sort(results);
+
+        auto expected = std::vector<std::tuple<size_t, size_t, size_t>> {
+            {0, 0, 3},
+            {0, 0, 3},
+            {0, 1, 7},
+            {0, 1, 7},
+            {1, 0, 7},
+            {1, 0, 7},
+            {1, 1, 3},
+            {1, 1, 3},
+        };
+        CHECK(results == expected);
+    }
+}
+
+TEST_CASE("check searches with k-mer lookup table", "[searches][kmer]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    auto rng   = std::mt19937{17};
+    auto input = fmc::test::generateText(rng, {3000, 10, 1500});
+    // queries are substrings of the input with some substitutions, some are shorter than k
+    auto queries = fmc::test::sampleQueries(rng, input, 200, {3, 4, 5, 12, 20}, /*.maxSubstitutions=*/1);
+
+    auto index = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+    auto indexWithTable = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+    indexWithTable.kmerLookup = fmc::KMerLookupTable{indexWithTable, /*k=*/4, /*threadNbr=*/2};
+    REQUIRE(indexWithTable.kmerLookup.entries.size() == 256);
+
+    SECTION("search no errors, single search") {
+        for (auto const& query : queries) {
+            auto expected = fmc::search_no_errors::search(index, query);
+            auto cur      = fmc::search_no_errors::search(indexWithTable, query);
+            CHECK(cur.len == expected.len);
+            if (!expected.empty()) {
+                CHECK(cur.lb == expected.lb);
+            }
+        }
+    }
+
+    SECTION("search no errors, interleaved batches") {
+        auto collect = [&](Index const& _index) {
+            auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+            fmc::search_no_errors::search(_index, queries, [&](size_t qidx, auto cursor) {
+                results.emplace_back(qidx, cursor.lb, cursor.len);
+            });
+            std::ranges::sort(results);
+            return results;
+        };
+        CHECK(collect(indexWithTable) == collect(index));
+    }
+
+    SECTION("search ng26") {
+        // search schemes require longer queries
+        auto longQueries = std::vector<std::vector<uint8_t>>{};
+        std::ranges::copy_if(queries, std::back_inserter(longQueries), [](auto const& q) { return q.size() >= 12; });
+
+        auto collect = [&]<bool Edit>(Index const& _index, size_t errors) {
+            auto results = std::vector<std::tuple<size_t, size_t, size_t, size_t>>{};
+            fmc::search_ng26::search<Edit>(_index, longQueries, errors, [&](size_t qidx, auto cursor, size_t e) {
+                results.emplace_back(qidx, cursor.lb, cursor.len, e);
+            });
+            return results;
+        };
+        for (size_t errors : {0, 1, 2}) {
+            INFO(errors);
+            CHECK(collect.template operator()<true>(indexWithTable, errors) == collect.template operator()<true>(index, errors));
+            CHECK(collect.template operator()<false>(indexWithTable, errors) == collect.template operator()<false>(index, errors));
+        }
+    }
+}
+
+TEST_CASE("check hybrid search with in-text verification", "[searches][hybrid]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    auto rng   = std::mt19937{11};
+    auto input = fmc::test::generateText(rng, {300, 120, 250});
+    // add some repeats
+    std::copy(input[0].begin() + 10, input[0].begin() + 60, input[2].begin() + 100);
+    std::copy(input[0].begin() + 10, input[0].begin() + 60, input[1].begin() + 30);
+
+    size_t const errors = 2;
+    auto queries = fmc::test::sampleQueries(rng, input, 30, {20}, /*.maxSubstitutions=*/errors);
+
+    auto index = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+    index.isa  = fmc::SampledISA{index, 8};
+
+    using Hit = std::tuple<size_t, size_t, size_t, size_t>;
+    auto runSearch = [&]<bool Edit>(size_t threshold) {
+        auto hits = std::vector<Hit>{};
+        fmc::search_hybrid::search<Edit>(index, queries, errors, threshold, [&](size_t qidx, size_t seqId, size_t pos, size_t e) {
+            hits.emplace_back(qidx, seqId, pos, e);
+        });
+        return hits;
+    };
+
+    // smallest edit distance between the query and any text starting at pos
+    auto editDistance = [&](std::vector<uint8_t> const& query, size_t seqId, size_t pos) {
+        auto const& seq = input[seqId];
+        auto row = std::vector<size_t>(seq.size() - pos + 1);
+        for (size_t j{0}; j < row.size(); ++j) row[j] = j;
+        for (size_t i{1}; i <= query.size(); ++i) {
+            size_t diag = row[0];
+            row[0] = i;
+            for (size_t j{1}; j < row.size(); ++j) {
+                auto v = std::min({diag + (query[i-1] != seq[pos + j - 1]), row[j] + 1, row[j-1] + 1});
+                diag   = row[j];
+                row[j] = v;
+            }
+        }
+        return std::ranges::min(row);
+    };
+
+    SECTION("hamming distance") {
+        auto expected = std::vector<Hit>{};
+        for (size_t qidx{0}; qidx < queries.size(); ++qidx) {
+            auto const& query = queries[qidx];
+            for (size_t seqId{0}; seqId < input.size(); ++seqId) {
+                auto const& seq = input[seqId];
+                for (size_t pos{0}; pos + query.size() <= seq.size(); ++pos) {
+                    size_t e{};
+                    for (size_t i{0}; i < query.size(); ++i) {
+                        e += (query[i] != seq[pos+i]);
+                    }
+                    if (e <= errors) {
+                        expected.emplace_back(qidx, seqId, pos, e);
+                    }
+                }
+            }
+        }
+        for (size_t threshold : {0, 1, 4, 1000}) {
+            INFO(threshold);
+            CHECK(runSearch.template operator()<false>(threshold) == expected);
+        }
+    }
+
+    // search_ng26 + locate, each position once with its lowest number of errors
+    auto runNg26 = [&]<bool Edit>() {
+        auto hits = std::vector<Hit>{};
+        fmc::search_ng26::search<Edit>(index, queries, errors, [&](size_t qidx, auto cur, size_t e) {
+            for (auto [seqId, pos, offset] : fmc::LocateLinear{index, cur}) {
+                hits.emplace_back(qidx, seqId, pos + offset, e);
+            }
+        });
+        std::ranges::sort(hits);
+        auto [first, last] = std::ranges::unique(hits, [](auto const& lhs, auto const& rhs) {
+            return std::get<0>(lhs) == std::get<0>(rhs) && std::get<1>(lhs) == std::get<1>(rhs) && std::get<2>(lhs) == std::get<2>(rhs);
+        });
+        hits.erase(first, last);
+        return hits;
+    };
+
+    SECTION("hamming distance, same results as search_ng26") {
+        for (size_t threshold : {0, 4, 1000}) {
+            INFO(threshold);
+            CHECK(runSearch.template operator()<false>(threshold) == runNg26.template operator()<false>());
+        }
+    }
+
+    SECTION("edit distance") {
+        auto backtracking = runSearch.template operator()<true>(0);
+        // without verification the results are the ones of search_ng26
+        CHECK(backtracking == runNg26.template operator()<true>());
+        for (size_t threshold : {1, 4, 1000}) {
+            INFO(threshold);
+            auto hits = runSearch.template operator()<true>(threshold);
+            // every hit is a valid alignment
+            for (auto [qidx, seqId, pos, e] : hits) {
+                CHECK(e <= errors);
+                CHECK(editDistance(queries[qidx], seqId, pos) <= e);
+            }
+            // every occurrence found by backtracking is also found by verification, up to a shift of the start position
+            for (auto [qidx, seqId, pos, e] : backtracking) {
+                INFO(qidx << " " << seqId << " " << pos);
+                auto iter = std::ranges::find_if(hits, [&](auto const& h) {
+                    auto [qidx2, seqId2, pos2, e2] = h;
+                    return qidx == qidx2 && seqId == seqId2 && pos2 + errors >= pos && pos2 <= pos + errors;
+                });
+                CHECK(iter != hits.end());
+            }
+        }
+    }
+
+    SECTION("missing inverse suffix array") {
+        auto index2 = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+        CHECK_THROWS(fmc::search_hybrid::search<true>(index2, queries, errors, 4, [](size_t, size_t, size_t, size_t) {}));
+    }
+}
+
+TEST_CASE("check search scheme cache", "[searches][cache]") {
+    using namespace fmc::search_scheme;
+
+    SECTION("cached schemes are identical to generated schemes") {
+        CHECK(fmc::getCachedSearchScheme<true>(0, 2) == generator::h2(4, 0, 2));
+        CHECK(fmc::getCachedSearchScheme<true>(0, 2, /*.shortLen=*/true) == generator::h2(3, 0, 2));
+        CHECK(fmc::getCachedSearchScheme<false>(1, 3) == limitToHamming(generator::h2(5, 1, 3)));
+        for (size_t length : {10, 27, 10, 50}) {
+            CHECK(fmc::getCachedSearchScheme<true>(length, size_t{0}, size_t{2}) == expand(generator::h2(4, 0, 2), length));
+            CHECK(fmc::getCachedSearchScheme<false>(length, size_t{0}, size_t{2}) == limitToHamming(expand(generator::h2(4, 0, 2), length)));
+            CHECK(fmc::getCachedPartition(3, length) == createUniformPartition(3, length));
+        }
+    }
+
+    SECTION("mixed lengths on multiple threads") {
+        fmc::prewarmSearchSchemes<true>(20, 30, 0, 2);
+        CHECK(fmc::detail::expandedSchemeCache<true>().size() >= 11);
+
+        auto threads = std::vector<std::thread>{};
+        auto failures = std::atomic_size_t{};
+        for (size_t t{0}; t < 4; ++t) {
+            threads.emplace_back([&, t]() {
+                for (size_t i{0}; i < 50; ++i) {
+                    auto length = 15 + (i * 7 + t) % 20;
+                    auto const& ss = fmc::getCachedSearchScheme<true>(length, size_t{0}, size_t{2});
+                    auto const& p  = fmc::getCachedPartition(4, length);
+                    if (ss != expand(generator::h2(4, 0, 2), length)) failures += 1;
+                    if (p != createUniformPartition(4, length)) failures += 1;
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        CHECK(failures == 0);
+    }
+
+    SECTION("cache is bounded") {
+        fmc::setSearchSchemeCacheCapacity(3);
+        auto const& ss = fmc::getCachedSearchScheme<true>(size_t{100}, size_t{0}, size_t{1});
+        auto expected  = expand(generator::h2(3, 0, 1), 100);
+        for (size_t length{10}; length < 20; ++length) {
+            fmc::getCachedPartition(2, length);
+        }
+        CHECK(fmc::detail::partitionCache().size() <= 3);
+        CHECK(ss == expected); // still valid, even if evicted from the shared cache
+        fmc::setSearchSchemeCacheCapacity(fmc::detail::searchSchemeCacheCapacity);
+    }
+
+    SECTION("capacity 0 disables caching") {
+        auto cache = fmc::SharedCache<size_t, std::vector<size_t>>{0};
+        auto value = cache.get(5, []() { return std::vector<size_t>{1, 2, 3}; });
+        REQUIRE(value);
+        CHECK(*value == std::vector<size_t>{1, 2, 3});
+        CHECK(cache.size() == 0);
+
+        fmc::setSearchSchemeCacheCapacity(0);
+        CHECK(fmc::getCachedPartition(3, 77) == createUniformPartition(3, 77));
+        CHECK(fmc::detail::partitionCache().size() == 0);
+        fmc::setSearchSchemeCacheCapacity(fmc::detail::searchSchemeCacheCapacity);
+    }
+}
+
+TEST_CASE("check index-aware search scheme tuning", "[searches][tuner]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    // skewed symbol distribution with many repeats
+    auto rng   = std::mt19937{17};
+    auto input = fmc::test::generateText(rng, {400, 300});
+    for (auto& seq : input) {
+        for (auto& c : seq) {
+            if (rng() % 4 != 0) c = 1;
+        }
+    }
+    std::copy(input[0].begin() + 20, input[0].begin() + 120, input[1].begin() + 50);
+    auto index = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+
+    size_t const length = 16;
+    size_t const errors = 2;
+    auto config = fmc::scheme_tuner::Config{};
+    config.sampleCount = 20;
+    config.generators  = {"h2-k2", "pigeon_opt", "kianfar"};
+
+    auto queries = fmc::scheme_tuner::sampleQueries(index, length, 20, errors, /*.seed=*/3);
+    CHECK(queries.size() == 20);
+
+    auto runSearch = [&]<bool Edit>(fmc::search_scheme::Scheme const& ss, std::vector<size_t> const& partition) {
+        auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+        fmc::search_ng26::search<Edit>(index, queries, ss, partition, [&](size_t qidx, auto cursor, size_t) {
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                results.emplace_back(qidx, sid, spos+offset);
+            }
+        });
+        std::ranges::sort(results);
+        auto [first, last] = std::ranges::unique(results);
+        results.erase(first, last);
+        return results;
+    };
+
+    auto check = [&]<bool Edit>() {
+        auto res = fmc::scheme_tuner::tune<Edit>(index, length, 0, errors, config);
+        INFO(res.generator);
+        CHECK(fmc::search_scheme::isComplete(res.scheme, 0, errors));
+        CHECK(std::accumulate(res.partition.begin(), res.partition.end(), size_t{0}) == length);
+        CHECK(res.expanded.size() == res.scheme.size());
+        CHECK(res.nodesPerPart.size() == res.partition.size());
+        CHECK(std::abs(std::accumulate(res.nodesPerPart.begin(), res.nodesPerPart.end(), 0.) - res.nodes) < 1e-6);
+
+        // never worse than the uniformly partitioned h2 scheme
+        auto h2 = fmc::search_scheme::generator::all.at("h2-k2").generator(0, errors, Index::Sigma, index.size());
+        auto h2Partition = fmc::search_scheme::expandCount(h2[0].pi.size(), length);
+        auto h2Queries   = fmc::scheme_tuner::sampleQueries(index, length, config.sampleCount, errors, config.seed);
+        auto h2Expanded  = fmc::search_scheme::expand(h2, h2Partition);
+        if constexpr (!Edit) {
+            h2Expanded = fmc::search_scheme::limitToHamming(h2Expanded);
+        }
+        auto h2Nodes = fmc::scheme_tuner::countNodes<Edit>(index, h2Queries, h2Expanded, h2Partition);
+        CHECK(res.nodes <= double(std::accumulate(h2Nodes.begin(), h2Nodes.end(), size_t{0})) / h2Queries.size());
+
+        // the tuned scheme finds the same occurrences
+        auto tunedHits = runSearch.template operator()<Edit>(res.scheme, res.partition);
+        auto h2Hits    = runSearch.template operator()<Edit>(h2, h2Partition);
+        if constexpr (!Edit) {
+            CHECK(tunedHits == h2Hits);
+        } else {
+            // with edit distance, the same occurrence might be reported with a shifted start position
+            for (auto [qidx, sid, pos] : h2Hits) {
+                INFO(qidx << " " << sid << " " << pos);
+                CHECK(std::ranges::any_of(tunedHits, [&](auto const& h) {
+                    auto [qidx2, sid2, pos2] = h;
+                    return qidx == qidx2 && sid == sid2 && pos2 + errors >= pos && pos2 <= pos + errors;
+                }));
+            }
+        }
+    };
+
+    SECTION("hamming distance") {
+        check.template operator()<false>();
+    }
+    SECTION("edit distance") {
+        check.template operator()<true>();
+    }
+    SECTION("invalid configurations") {
+        config.generators = {"unknown"};
+        CHECK_THROWS(fmc::scheme_tuner::tune<false>(index, length, 0, errors, config));
+        config.generators = {"h2-k2"};
+        CHECK_THROWS(fmc::scheme_tuner::tune<false>(index, 1000, 0, errors, config));
+    }
+}
+
+TEST_CASE("check search instrumentation", "[searches][instrumentation]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    auto rng     = std::mt19937{23};
+    auto input   = fmc::test::generateText(rng, {300, 200});
+    auto queries = fmc::test::sampleQueries(rng, input, 10, {15}, /*.maxSubstitutions=*/1);
+    auto index = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+
+    size_t const errors = 2;
+    auto const& scheme = fmc::getCachedSearchScheme<true>(0, errors);
+    auto partition     = fmc::search_scheme::createUniformPartition(scheme, 15);
+
+    using Hit = std::tuple<size_t, size_t, size_t, size_t>;
+    auto check = [&](auto search) {
+        auto expected = std::vector<Hit>{};
+        search([&](size_t qidx, auto cur, size_t e) {
+            expected.emplace_back(qidx, cur.lb, cur.len, e);
+        }, fmc::instrumentation::Disabled{});
+
+        auto stats = fmc::instrumentation::Counters{};
+        auto hits  = std::vector<Hit>{};
+        size_t rows{};
+        search([&](size_t qidx, auto cur, size_t e) {
+            hits.emplace_back(qidx, cur.lb, cur.len, e);
+            rows += cur.count();
+        }, stats);
+
+        // instrumentation does not change the results
+        CHECK(hits == expected);
+
+        REQUIRE(stats.queries.size() == queries.size());
+        CHECK(stats.total.results == rows);
+        CHECK(stats.total.nodes.size() == partition.size());
+        CHECK(stats.total.totalNodes() > 0);
+        CHECK(stats.total.extensions() >= stats.total.totalNodes() / index.Sigma);
+        auto sum = fmc::instrumentation::QueryCounters{};
+        for (size_t i{0}; i < stats.queries.size(); ++i) {
+            CHECK(stats.queries[i].qidx == i);
+            CHECK(stats.queries[i].results > 0); // every query is taken from the text
+            sum.add(stats.queries[i]);
+        }
+        CHECK(sum.nodes == stats.total.nodes);
+        CHECK(sum.extensions() == stats.total.extensions());
+        CHECK(sum.results == stats.total.results);
+
+        // without per query recording only the aggregate is kept
+        auto statsTotal = fmc::instrumentation::Counters{.recordQueries = false};
+        search([&](size_t, auto, size_t) {}, statsTotal);
+        CHECK(statsTotal.queries.empty());
+        CHECK(statsTotal.queryCount == queries.size());
+        CHECK(statsTotal.total.nodes == stats.total.nodes);
+        CHECK(statsTotal.total.extensions() == stats.total.extensions());
+        CHECK(statsTotal.total.results == stats.total.results);
+        CHECK(statsTotal.nodesPerQuery() == stats.nodesPerQuery());
+        return stats;
+    };
+
+    SECTION("search_ng26") {
+        check([&](auto const& delegate, auto&& stats) {
+            fmc::search_ng26::search<true>(index, queries, scheme, partition, delegate, stats);
+        });
+    }
+    SECTION("search_ng28") {
+        check([&](auto const& delegate, auto&& stats) {
+            fmc::search_ng28::search<true>(index, queries, scheme, partition, delegate, stats);
+        });
+    }
+
+    SECTION("nodes skipped by the k-mer lookup table are counted") {
+        auto exactQueries = std::vector<std::vector<uint8_t>>{};
+        for (size_t i{0}; i < 10; ++i) {
+            auto const& seq = input[rng() % input.size()];
+            auto pos = rng() % (seq.size() - 15);
+            exactQueries.emplace_back(seq.begin() + pos, seq.begin() + pos + 15);
+        }
+        auto indexWithTable = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+        indexWithTable.kmerLookup = fmc::KMerLookupTable{indexWithTable, /*k=*/4};
+
+        auto stats      = fmc::instrumentation::Counters{};
+        auto statsTable = fmc::instrumentation::Counters{};
+        fmc::search_ng26::search<true>(index, exactQueries, scheme, partition, [](size_t, auto, size_t) {}, stats);
+        fmc::search_ng26::search<true>(indexWithTable, exactQueries, scheme, partition, [](size_t, auto, size_t) {}, statsTable);
+        CHECK(statsTable.total.extendSymb < stats.total.extendSymb); // the table was used
+        CHECK(statsTable.total.nodes == stats.total.nodes);
+    }
+
+    SECTION("locate steps and json export") {
+        auto stats = fmc::instrumentation::Counters{};
+        stats.beginQuery(0, 1);
+        size_t steps{};
+        for (size_t i{0}; i < index.size(); ++i) {
+            steps += std::get<2>(index.locate(i));
+            CHECK(index.locate(i, stats) == index.locate(i));
+        }
+        CHECK(stats.total.locateSteps == steps);
+        CHECK(stats.queries[0].locateSteps == steps);
+
+        stats.predict<true>(fmc::search_scheme::expand(scheme, partition), 4, index.size());
+        CHECK(stats.predictedNodes > 0);
+
+        auto json = stats.toJson();
+        CHECK(json.starts_with("{\"queries\": 1, \"total\": {\"qidx\": 0, \"nodes\": 0, \"nodes_per_part\": [0]"));
+        CHECK(json.find("\"locate_steps\": " + std::to_string(steps)) != std::string::npos);
+        CHECK(json.find("\"predicted_nodes_per_query\": ") != std::string::npos);
+        CHECK(json.ends_with("]}"));
+        CHECK(stats.toJson(/*.perQuery=*/false).find("\"per_query\"") == std::string::npos);
+
+        auto other = stats;
+        stats.merge(other);
+        CHECK(stats.queries.size() == 2);
+        CHECK(stats.total.locateSteps == 2*steps);
+    }
+}
+
+TEST_CASE("check searching deduplicated queries", "[searches][deduplicate]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    auto rng   = std::mt19937{24};
+    auto input = fmc::test::generateText(rng, {400, 250, 300});
+
+    // few distinct queries, many duplicates
+    auto distinct = fmc::test::sampleQueries(rng, input, 10, {6, 11, 17, 25}, /*.maxSubstitutions=*/1);
+    auto complement = [](uint8_t c) -> uint8_t { return 5 - c; };
+    auto reverseComplement = [&](std::vector<uint8_t> query) {
+        std::ranges::reverse(query);
+        std::ranges::transform(query, query.begin(), complement);
+        return query;
+    };
+    auto queries = std::vector<std::vector<uint8_t>>{};
+    for (size_t i{0}; i < 60; ++i) {
+        queries.push_back(distinct[rng() % distinct.size()]);
+    }
+    queries.push_back(reverseComplement(queries[0]));
+
+    auto index = Index{input, /*samplingRate*/4, /*threadNbr*/1};
+
+    SECTION("grouping") {
+        auto groups = fmc::groupQueries(queries);
+        CHECK(groups.size() <= distinct.size() + 1);
+        CHECK(groups.members.size() == queries.size());
+        for (size_t qidx{0}; qidx < queries.size(); ++qidx) {
+            auto group = groups.groupOf[qidx];
+            CHECK(queries[groups.representatives[group]] == queries[qidx]);
+            CHECK(groups.representatives[group] <= qidx);
+            CHECK(std::ranges::count(groups.membersOf(group), qidx) == 1);
+            CHECK(!groups.reverseComplement[qidx]);
+        }
+        for (size_t g{0}; g < groups.size(); ++g) {
+            CHECK(groups.membersOf(g).front() == groups.representatives[g]);
+            CHECK(std::ranges::is_sorted(groups.membersOf(g)));
+        }
+
+        auto groupsRC = fmc::groupQueries(queries, complement);
+        CHECK(groupsRC.size() == groups.size() - 1);
+        auto rc = queries.size() - 1;
+        CHECK(groupsRC.reverseComplement[rc]);
+        CHECK(groupsRC.groupOf[rc] == groupsRC.groupOf[0]);
+        CHECK(std::ranges::count(groupsRC.reverseComplement, true) == 1);
+    }
+
+    using Result = std::tuple<size_t, size_t, size_t, size_t>;
+    auto collect = [&](auto const& search) {
+        auto results = std::vector<Result>{};
+        search([&](size_t qidx, auto const& cursor, size_t errors) {
+            for (auto [sid, spos, offset] : fmc::LocateLinear{index, cursor}) {
+                results.emplace_back(qidx, sid, spos+offset, errors);
+            }
+        });
+        std::ranges::sort(results);
+        return results;
+    };
+
+    SECTION("search_no_errors") {
+        auto expected = collect([&](auto report) {
+            fmc::search_no_errors::search(index, queries, [&](size_t qidx, auto const& cursor) { report(qidx, cursor, 0); });
+        });
+        CHECK(!expected.empty());
+        auto results = collect([&](auto report) {
+            fmc::search_no_errors::search_deduplicated(index, queries, [&](size_t qidx, auto const& cursor) { report(qidx, cursor, 0); });
+        });
+        CHECK(results == expected);
+    }
+
+    SECTION("search with errors") {
+        for (size_t errors : {0, 1, 2}) {
+            auto expected = collect([&](auto report) {
+                fmc::search</*EditDistance=*/true>(index, queries, errors, report);
+            });
+            auto results = collect([&](auto report) {
+                fmc::search_deduplicated</*EditDistance=*/true>(index, queries, errors, report);
+            });
+            CHECK(results == expected);
+        }
+    }
+
+    SECTION("search_n with errors") {
+        auto expected = collect([&](auto report) {
+            fmc::search_n</*EditDistance=*/false>(index, queries, 2, /*.n=*/3, report);
+        });
+        auto groups  = fmc::groupQueries(queries);
+        auto results = collect([&](auto report) {
+            fmc::search_n_deduplicated</*EditDistance=*/false>(index, queries, 2, /*.n=*/3, groups, report);
+        });
+        CHECK(results == expected);
+
+        auto results2 = collect([&](auto report) {
+            fmc::search_n_deduplicated</*EditDistance=*/false>(index, queries, 2, /*.n=*/3, report);
+        });
+        CHECK(results2 == expected);
+    }
 }
@@ -0,0 +1,173 @@
+// SPDX-FileCopyrightText: 2025 Simon Gene Gottlieb
+// SPDX-License-Identifier: CC0-1.0
+
+#include <catch2/catch_all.hpp>
+#include <fmindex-collection/fmindex/BiFMIndex.h>
+#include <fmindex-collection/locate.h>
+#include <fmindex-collection/search/Seeding.h>
+#include <random>
+#include <span>
+
+namespace {
+
+// number of occurrences of `_query[begin, end)` inside `_text`
+auto countOccurrences(std::vector<std::vector<uint8_t>> const& _text, std::vector<uint8_t> const& _query, size_t _begin, size_t _end) -> size_t {
+    size_t ct{0};
+    for (auto const& ref : _text) {
+        auto needle = std::span{_query}.subspan(_begin, _end - _begin);
+        for (auto iter = ref.begin(); ; ++iter) {
+            iter = std::search(iter, ref.end(), needle.begin(), needle.end());
+            if (iter == ref.end()) break;
+            ++ct;
+        }
+    }
+    return ct;
+}
+
+// all SMEMs as (begin, end, count), computed by brute force
+auto naiveSmems(std::vector<std::vector<uint8_t>> const& _text, std::vector<uint8_t> const& _query, size_t _minOcc, size_t _minLength) {
+    // longest match starting at each position
+    auto ends = std::vector<size_t>(_query.size());
+    for (size_t b{0}; b < _query.size(); ++b) {
+        ends[b] = b;
+        while (ends[b] < _query.size() && countOccurrences(_text, _query, b, ends[b]+1) >= _minOcc) {
+            ++ends[b];
+        }
+    }
+    auto results = std::vector<std::tuple<size_t, size_t, size_t>>{};
+    for (size_t b{0}; b < _query.size(); ++b) {
+        if (ends[b] == b) continue;
+        bool contained = b > 0 && ends[b-1] >= ends[b];
+        if (contained || ends[b] - b < _minLength) continue;
+        results.emplace_back(b, ends[b], countOccurrences(_text, _query, b, ends[b]));
+    }
+    return results;
+}
+
+}
+
+TEST_CASE("checking smem seeding", "[seeding]") {
+    using Index = fmc::BiFMIndex<5>;
+
+    auto rng  = std::mt19937_64{42};
+    auto text = fmc::test::generateText(rng, {300, 300, 300});
+    // repeat a piece, so some seeds have multiple occurrences
+    text[2].insert(text[2].end(), text[0].begin() + 50, text[0].begin() + 120);
+
+    // queries are pieces of the text with some substitutions
+    auto queries = fmc::test::sampleQueries(rng, text, 30, {20, 37, 52, 79}, /*.maxSubstitutions=*/3);
+    queries.push_back({});     // empty query
+    queries.push_back({1, 0}); // invalid symbol
+
+    auto index = Index{text, /*samplingRate*/4, /*threadNbr*/1};
+
+    using Result = std::tuple<size_t, size_t, size_t>;
+    auto toTuples = [](auto const& seeds) {
+        auto results = std::vector<Result>{};
+        for (auto const& seed : seeds) {
+            results.emplace_back(seed.begin, seed.end, seed.count());
+        }
+        return results;
+    };
+
+    SECTION("smems match a brute force computation") {
+        for (size_t minOcc : {1, 2, 3}) {
+            for (size_t minLength : {1, 5, 12}) {
+                auto options = fmc::seeding::Options{.minLength = minLength, .minOcc = minOcc};
+                for (auto const& query : queries) {
+                    INFO("minOcc " << minOcc << " minLength " << minLength);
+                    CHECK(toTuples(fmc::seeding::smems(index, query, options)) == naiveSmems(text, query, minOcc, minLength));
+                }
+            }
+        }
+    }
+
+    SECTION("maxOcc filters repetitive seeds") {
+        auto options = fmc::seeding::Options{.minLength = 1, .maxOcc = 1};
+        for (auto const& query : queries) {
+            auto expected = naiveSmems(text, query, 1, 1);
+            std::erase_if(expected, [](auto const& e) { return std::get<2>(e) > 1; });
+            CHECK(toTuples(fmc::seeding::smems(index, query, options)) == expected);
+        }
+    }
+
+    SECTION("reseeding adds shorter seeds with more occurrences") {
+        // query spans the repeated piece, the unique smem hides the second occurrence
+        auto query = std::vector<uint8_t>(text[0].begin() + 40, text[0].begin() + 130);
+
+        auto smems   = fmc::seeding::smems(index, query, {.minLength = 10});
+        auto reseeds = fmc::seeding::smems(index, query, {.minLength = 10, .reseed = true, .reseedLength = 20, .reseedMaxOcc = 1});
+        REQUIRE(smems.size() == 1);
+        CHECK(smems[0].count() == 1);
+        CHECK(reseeds.size() > smems.size());
+
+        // every smem is still reported, every seed is an exact match
+        for (auto const& seed : smems) {
+            CHECK(std::ranges::count_if(reseeds, [&](auto const& s) { return s.begin == seed.begin && s.end == seed.end; }) == 1);
+        }
+        for (auto const& seed : reseeds) {
+            CHECK(seed.count() == countOccurrences(text, query, seed.begin, seed.end));
+        }
+        CHECK(std::ranges::any_of(reseeds, [](auto const& s) { return s.count() == 2 && s.length() >= 10; }));
+    }
+
+    SECTION("seeds can be located") {
+        auto options = fmc::seeding::Options{.minLength = 8};
+        for (auto const& query : queries) {
+            auto seeds = fmc::seeding::smems(index, query, options);
+            auto cursors = std::vector<fmc::select_cursor_t<Index>>{};
+            for (auto const& seed : seeds) {
+                cursors.push_back(seed.cursor);
+            }
+            auto positions = fmc::locateBatch(index, cursors);
+            size_t i{0};
+            for (auto const& seed : seeds) {
+                for (auto [sid, spos, offset] : fmc::LocateLinear{index, seed.cursor}) {
+                    REQUIRE(i < positions.size());
+                    CHECK(positions[i] == std::tuple<size_t, size_t>{sid, spos+offset});
+                    ++i;
+
+                    auto const& ref = text[sid];
+                    REQUIRE(spos + offset + seed.length() <= ref.size());
+                    CHECK(std::equal(query.begin() + seed.begin, query.begin() + seed.end, ref.begin() + spos + offset));
+                }
+            }
+            CHECK(i == positions.size());
+        }
+    }
+
+    SECTION("index without delimiters, symbol 0 is a valid symbol") {
+        // symbols 0..3
+        auto text0 = fmc::test::generateText(rng, {300});
+        std::ranges::transform(text0[0], text0[0].begin(), [](uint8_t c) -> uint8_t { return c - 1; });
+        auto index0 = fmc::BiFMIndex<4>::NoDelim{text0, /*samplingRate*/4, /*threadNbr*/1};
+        auto options = fmc::seeding::Options{.minLength = 12};
+        for (auto const& query : fmc::test::sampleQueries(rng, text0, 10, {60}, /*.maxSubstitutions=*/1, /*.symbols=*/3)) {
+            CHECK(toTuples(fmc::seeding::smems(index0, query, options)) == naiveSmems(text0, query, 1, 12));
+        }
+    }
+
+    SECTION("multiple queries, single and multi threaded") {
+        auto options = fmc::seeding::Options{.minLength = 5, .reseed = true, .reseedLength = 15};
+        auto expected = std::vector<std::tuple<size_t, Result>>{};
+        for (size_t qidx{0}; qidx < queries.size(); ++qidx) {
+            for (auto r : toTuples(fmc::seeding::smems(index, queries[qidx], options))) {
+                expected.emplace_back(qidx, r);
+            }
+        }
+
+        auto results = std::vector<std::tuple<size_t, Result>>{};
+        fmc::seeding::smems(index, queries, options, [&](size_t qidx, auto const& seed) {
+            results.emplace_back(qidx, Result{seed.begin, seed.end, seed.count()});
+        });
+        CHECK(results == expected);
+
+        for (size_t threadNbr : {1, 2, 4}) {
+            results.clear();
+            fmc::seeding::smems_parallel(index, queries, options, threadNbr, [&](size_t qidx, auto const& seed) {
+                results.emplace_back(qidx, Result{seed.begin, seed.end, seed.count()});
+            }, /*.chunkSize=*/3);
+            CHECK(results == expected);
+        }
+    }
+}
@@ -34,6 +34,7 @@ using AllStrings = Variant<
     fmc::string::MultiaryWavelet_512_64k,
     fmc::string::MultiaryWavelet_s16,
     fmc::string::MultiaryWavelet_s256,
+    fmc::string::RunLengthEncoded_512_64k,
 #else
     fmc::string::InterleavedBitvector16,
     fmc::string::FlattenedBitvectors_64_64k,
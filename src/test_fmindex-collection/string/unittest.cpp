@@ -49,6 +49,31 @@ TEST_CASE("check if rank on the symbol vectors is working, all sizes", "[string]
     }
 
 }
+TEST_CASE("check multi threaded construction of FlattenedBitvectors2L", "[string][threads]") {
+    using String = fmc::string::FlattenedBitvectors2L<5, 64, 1024>;
+
+    for (size_t length : {0, 1, 1023, 1024, 20000}) {
+        INFO(length);
+        auto text = generateText<0, String::Sigma>(length);
+
+        auto expected = String{std::span{text}};
+        for (size_t threadNbr : {1, 4}) {
+            INFO(threadNbr);
+            auto vec = String{std::span{text}, threadNbr};
+            REQUIRE(vec.size() == expected.size());
+            for (size_t i{0}; i < text.size(); ++i) {
+                CHECK(vec.symbol(i) == text[i]);
+            }
+            for (size_t i{0}; i <= text.size(); ++i) {
+                for (size_t symb{0}; symb < String::Sigma; ++symb) {
+                    CHECK(vec.rank(i, symb) == expected.rank(i, symb));
+                    CHECK(vec.prefix_rank(i, symb) == expected.prefix_rank(i, symb));
+                }
+            }
+        }
+    }
+}
+
 TEST_CASE("hand counted, test with 255 alphabet", "[string][255][small]") {
 
     auto text = std::vector<uint8_t>{'H', 'a', 'l', 'l', 'o', ' ', 'W', 'e', 'l', 't'};
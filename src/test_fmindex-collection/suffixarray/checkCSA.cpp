@@ -3,6 +3,7 @@
 // SPDX-License-Identifier: CC0-1.0
 
 #include <catch2/catch_all.hpp>
+#include <fmindex-collection/bitvector/EliasFanoBitvector.h>
 #include <fmindex-collection/suffixarray/CSA.h>
 #include <fmindex-collection/utils.h>
 
@@ -48,6 +49,25 @@ TEST_CASE("check Compressed Suffix Array (CSA)", "[suffixarray][CSA]") {
         check(csa, expected);
     }
 
+    SECTION("sampling 3, mmser save and load") {
+        auto expected = std::vector<std::optional<std::tuple<uint32_t, uint32_t>>>(12);
+        expected[2] = {0, 0};
+        expected[3] = {1, 0};
+        expected[6] = {1, 3};
+        expected[8] = {0, 3};
+        {
+            auto csa = fmc::CSA {sa, /*.samplingRate =*/ 3, inputSizes};
+            mmser::saveFile("temp_test_csa_mmap", csa);
+        }
+        auto loaded = fmc::CSA{};
+        mmser::loadFile("temp_test_csa_mmap", loaded);
+        check(loaded, expected);
+
+        // the mapping must stay valid after moving the loaded csa
+        auto moved = std::move(loaded);
+        check(moved, expected);
+    }
+
     SECTION("sampling 4") {
         auto csa = fmc::CSA {sa, /*.samplingRate =*/ 4, inputSizes};
 
@@ -78,4 +98,23 @@ TEST_CASE("check Compressed Suffix Array (CSA)", "[suffixarray][CSA]") {
         expected[3] = {1, 0};
         check(csa, expected);
     }
+
+    SECTION("marks stored in an Elias-Fano bitvector") {
+        using EFCSA = fmc::BasicCSA<fmc::bitvector::EliasFanoBitvector<>>;
+        for (size_t samplingRate : {1, 3, 4, 5, 8}) {
+            auto csa   = fmc::CSA {sa, samplingRate, inputSizes};
+            auto efCsa = EFCSA{sa, samplingRate, inputSizes};
+
+            auto expected = std::vector<std::optional<std::tuple<uint64_t, uint64_t>>>{};
+            for (size_t i{0}; i < sa.size(); ++i) {
+                expected.push_back(csa.value(i));
+            }
+            check(efCsa, expected);
+
+            // constructed from a range of sampled entries
+            auto entries   = expected | std::views::transform([](auto const& e) -> std::optional<std::tuple<size_t, size_t>> { return e; });
+            auto fromRange = EFCSA{entries, /*.sequencesCount=*/ 2, /*.longestSequence=*/ 6};
+            check(fromRange, expected);
+        }
+    }
 }